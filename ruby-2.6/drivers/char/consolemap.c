@@ -15,6 +15,7 @@
 #include <linux/mm.h>
 #include <linux/slab.h>
 #include <linux/init.h>
+#include <linux/hash.h>
 #include <asm/uaccess.h>
 #include <linux/consolemap.h>
 #include <linux/vt_kern.h>
@@ -167,41 +168,109 @@ static unsigned short translations[][256] = {
 
 #define MAX_GLYPH 512		/* Max possible glyph value */
 
+#define UTF8_GLYPHS 4		/* Glyph table used in UTF-8 mode */
+#define NO_GLYPH 0xffff		/* Byte not handled by the glyph table */
+
+#define UNI_MAX		0x10ffff	/* Last Unicode code point */
+#define UNI_CACHE_BITS	8
+#define UNI_CACHE_SIZE	(1 << UNI_CACHE_BITS)
+
+/*
+ * Recent conv_uni_to_pc() results, direct mapped on the code point.
+ * Misses are cached too, so text outside the font stays cheap.
+ */
+struct uni_cache_entry {
+	u32		ucs;		/* 0: slot unused */
+	int		glyph;
+};
+
+#define UNIMAP_HASH_BITS 5
+#define UNIMAP_HASH_SIZE (1 << UNIMAP_HASH_BITS)
+
+/*
+ * PIO_UNIMAP loads with more entries than this drop the inverse tables
+ * instead of patching them, it is cheaper to rebuild them from scratch.
+ */
+#define INVERSE_DELTA_MAX 8
+
 static int inv_translate[MAX_NR_CONSOLES];
+static unsigned int user_map_serial;
 
 struct uni_pagedir {
 	u16 		**uni_pgdir[32];
 	unsigned long	refcount;
 	unsigned long	sum;
 	unsigned char	*inverse_translations[4];
+	unsigned int	inverse_user_serial;
+	u16		*glyph_translations[5];
+	unsigned int	glyph_user_serial;
+	struct uni_cache_entry *uni_cache;
+	struct hlist_node hash_node;
 	int		readonly;
 };
 
 static struct uni_pagedir *dflt;
 
-static void set_inverse_transl(struct vc_data *vc, struct uni_pagedir *p, int i)
+/*
+ * Finished unimaps, hashed on their content sum, so that loading a map
+ * some console already has costs a lookup and a single compare.  A map
+ * leaves the table before it is modified or released.
+ */
+static struct hlist_head unimap_hash[UNIMAP_HASH_SIZE];
+
+static int uni_to_glyph(struct uni_pagedir *p, long ucs);
+
+/*
+ * Inverse of translation table i: glyph -> byte.  Where several bytes
+ * show the same glyph the first printable one wins, so that e.g. '-'
+ * is preferred above SHY.
+ */
+static unsigned char *set_inverse_transl(struct uni_pagedir *p, int i)
 {
 	int j, glyph;
 	unsigned short *t = translations[i];
 	unsigned char *q;
 	
-	if (!p) return;
-	q = p->inverse_translations[i];
-
-	if (!q) {
-		q = p->inverse_translations[i] = (unsigned char *) 
-			kmalloc(MAX_GLYPH, GFP_KERNEL);
-		if (!q) return;
-	}
+	q = (unsigned char *) kmalloc(MAX_GLYPH, GFP_KERNEL);
+	if (!q) return NULL;
 	memset(q, 0, MAX_GLYPH);
 
 	for (j = 0; j < E_TABSZ; j++) {
-		glyph = conv_uni_to_pc(vc, t[j]);
+		glyph = uni_to_glyph(p, t[j]);
 		if (glyph >= 0 && glyph < MAX_GLYPH && q[glyph] < 32) {
 			/* prefer '-' above SHY etc. */
 		  	q[glyph] = j;
 		}
 	}
+	p->inverse_translations[i] = q;
+	return q;
+}
+
+/* Redo the inverse table entry of one glyph, by the same rule as above */
+static void update_inverse_glyph(struct uni_pagedir *p, int i, int glyph)
+{
+	unsigned short *t = translations[i];
+	int j, best = 0;
+
+	for (j = 0; j < E_TABSZ; j++) {
+		if (uni_to_glyph(p, t[j]) != glyph)
+			continue;
+		best = j;
+		if (j >= 32)
+			break;
+	}
+	p->inverse_translations[i][glyph] = best;
+}
+
+static void con_flush_inverse(struct uni_pagedir *p)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+		if (p->inverse_translations[i]) {
+			kfree(p->inverse_translations[i]);
+			p->inverse_translations[i] = NULL;
+		}
 }
 
 void set_translate(struct vc_data *vc, int m)
@@ -220,31 +289,86 @@ void set_translate(struct vc_data *vc, int m)
 unsigned char inverse_translate(struct vc_data *vc, int glyph)
 {
 	struct uni_pagedir *p;
+	int m = inv_translate[vc->vc_num];
+	unsigned char *q;
+
 	if (glyph < 0 || glyph >= MAX_GLYPH)
 		return 0;
-	else if (!(p = (struct uni_pagedir *)*vc->vc_uni_pagedir_loc) ||
-		 !p->inverse_translations[inv_translate[vc->vc_num]])
+	if (!(p = (struct uni_pagedir *)*vc->vc_uni_pagedir_loc))
+		return glyph;
+	if (m == USER_MAP && p->inverse_user_serial != user_map_serial) {
+		if (p->inverse_translations[USER_MAP]) {
+			kfree(p->inverse_translations[USER_MAP]);
+			p->inverse_translations[USER_MAP] = NULL;
+		}
+		p->inverse_user_serial = user_map_serial;
+	}
+	/* Built on first use, and shared by all consoles using this map */
+	if (!(q = p->inverse_translations[m]) &&
+	    !(q = set_inverse_transl(p, m)))
 		return glyph;
-	else
-		return p->inverse_translations[inv_translate[vc->vc_num]][glyph];
+	return q[glyph];
 }
 
-static void update_user_maps(struct vc_data *vc)
+static void con_flush_glyphs(struct uni_pagedir *p)
 {
-	struct uni_pagedir *p, *q = NULL;
 	int i;
-	
-	for (i = 0; i < vc->display_fg->vc_count; i++) {
-		struct vc_data *tmp = vc->display_fg->vc_cons[i];
 
-		if (!tmp)
+	for (i = 0; i <= UTF8_GLYPHS; i++)
+		if (p->glyph_translations[i]) {
+			kfree(p->glyph_translations[i]);
+			p->glyph_translations[i] = NULL;
+		}
+}
+
+/*
+ * Byte to glyph table for the plain text path of do_con_write().  Entry
+ * j is the glyph byte j shows up as under the current translation (with
+ * the same U+FFFD fallback do_con_write() applies), or NO_GLYPH if the
+ * byte needs the full treatment: controls, DEL, CSI and bytes without a
+ * glyph.  The tables hang off the unimap, so consoles sharing a font
+ * share them too; they are built on first use.
+ */
+const u16 *con_glyph_table(struct vc_data *vc)
+{
+	struct uni_pagedir *p = (struct uni_pagedir *)*vc->vc_uni_pagedir_loc;
+	int i = vc->vc_utf ? UTF8_GLYPHS : inv_translate[vc->vc_num];
+	unsigned short *t = translations[vc->vc_utf ? LAT1_MAP : i];
+	int j, glyph;
+	u16 *q;
+
+	if (!p)
+		return NULL;
+	if (i == USER_MAP && p->glyph_user_serial != user_map_serial) {
+		if (p->glyph_translations[USER_MAP]) {
+			kfree(p->glyph_translations[USER_MAP]);
+			p->glyph_translations[USER_MAP] = NULL;
+		}
+		p->glyph_user_serial = user_map_serial;
+	}
+	if ((q = p->glyph_translations[i]))
+		return q;
+	q = kmalloc(E_TABSZ * sizeof(u16), GFP_KERNEL);
+	if (!q)
+		return NULL;
+
+	for (j = 0; j < E_TABSZ; j++) {
+		q[j] = NO_GLYPH;
+		if (j < 32 || j == 127 || j == 128+27 || !t[j])
+			continue;
+		if (vc->vc_utf && j > 0x7f)
 			continue;
-		p = (struct uni_pagedir *)*tmp->vc_uni_pagedir_loc;
-		if (p && p != q) {
-			set_inverse_transl(tmp, p, USER_MAP);
-			q = p;
+		glyph = conv_uni_to_pc(vc, t[j]);
+		if (glyph == -4) {
+			glyph = conv_uni_to_pc(vc, 0xfffd);
+			if (glyph == -4)
+				glyph = j;
 		}
+		if (glyph >= 0 && glyph < MAX_GLYPH)
+			q[j] = glyph;
 	}
+	p->glyph_translations[i] = q;
+	return q;
 }
 
 /*
@@ -269,7 +393,7 @@ int con_set_trans_old(struct vc_data *vc, unsigned char __user *arg)
 		p[i] = UNI_DIRECT_BASE | uc;
 	}
 
-	update_user_maps(vc);
+	user_map_serial++;
 	return 0;
 }
 
@@ -303,7 +427,7 @@ int con_set_trans_new(struct vc_data *vc, ushort __user *arg)
 		p[i] = us;
 	}
 
-	update_user_maps(vc);
+	user_map_serial++;
 	return 0;
 }
 
@@ -340,6 +464,7 @@ static void con_release_unimap(struct uni_pagedir *p)
 	int i, j;
 
 	if (p == dflt) dflt = NULL;  
+	hlist_del_init(&p->hash_node);
 	for (i = 0; i < 32; i++) {
 		if ((p1 = p->uni_pgdir[i]) != NULL) {
 			for (j = 0; j < 32; j++)
@@ -349,11 +474,12 @@ static void con_release_unimap(struct uni_pagedir *p)
 		}
 		p->uni_pgdir[i] = NULL;
 	}
-	for (i = 0; i < 4; i++)
-		if (p->inverse_translations[i]) {
-			kfree(p->inverse_translations[i]);
-			p->inverse_translations[i] = NULL;
-		}
+	con_flush_inverse(p);
+	con_flush_glyphs(p);
+	if (p->uni_cache) {
+		kfree(p->uni_cache);
+		p->uni_cache = NULL;
+	}
 }
 
 void con_free_unimap(struct vc_data *vc)
@@ -368,52 +494,67 @@ void con_free_unimap(struct vc_data *vc)
 	kfree(p);
 }
   
-static int con_unify_unimap(struct vc_data *vc, struct uni_pagedir *p)
+static int con_same_unimap(struct uni_pagedir *p, struct uni_pagedir *q)
 {
-	struct uni_pagedir *q;
-	int i, j, k;
-	
-	for (i = 0; i < vc->display_fg->vc_count; i++) {
-		struct vc_data *tmp = vc->display_fg->vc_cons[i]; 
+	int j, k;
 
-		if (!tmp)
+	for (j = 0; j < 32; j++) {
+		u16 **p1, **q1;
+		p1 = p->uni_pgdir[j]; q1 = q->uni_pgdir[j];
+		if (!p1 && !q1)
 			continue;
-		q = (struct uni_pagedir *)*tmp->vc_uni_pagedir_loc;
-		if (!q || q == p || q->sum != p->sum)
-			continue;
-		for (j = 0; j < 32; j++) {
-			u16 **p1, **q1;
-			p1 = p->uni_pgdir[j]; q1 = q->uni_pgdir[j];
-			if (!p1 && !q1)
+		if (!p1 || !q1)
+			return 0;
+		for (k = 0; k < 32; k++) {
+			if (!p1[k] && !q1[k])
 				continue;
-			if (!p1 || !q1)
-				break;
-			for (k = 0; k < 32; k++) {
-				if (!p1[k] && !q1[k])
-					continue;
-				if (!p1[k] || !q1[k])
-					break;
-				if (memcmp(p1[k], q1[k], 64*sizeof(u16)))
-					break;
-			}
-			if (k < 32)
-				break;
-		}
-		if (j == 32) {
-			q->refcount++;
-			*vc->vc_uni_pagedir_loc = (unsigned long)q;
-			con_release_unimap(p);
-			kfree(p);
-			return 1;
+			if (!p1[k] || !q1[k])
+				return 0;
+			if (memcmp(p1[k], q1[k], 64*sizeof(u16)))
+				return 0;
 		}
 	}
+	return 1;
+}
+
+/*
+ * Called once p is complete: either swap it for an identical map some
+ * other console already uses, or make it available for sharing.
+ */
+static int con_unify_unimap(struct vc_data *vc, struct uni_pagedir *p)
+{
+	struct hlist_head *head;
+	struct hlist_node *n;
+	struct uni_pagedir *q;
+
+	head = unimap_hash + hash_long(p->sum, UNIMAP_HASH_BITS);
+	hlist_for_each_entry(q, n, head, hash_node) {
+		if (q == p || q->sum != p->sum || !con_same_unimap(p, q))
+			continue;
+		q->refcount++;
+		*vc->vc_uni_pagedir_loc = (unsigned long)q;
+		con_release_unimap(p);
+		kfree(p);
+		return 1;
+	}
+	hlist_add_head(&p->hash_node, head);
 	return 0;
 }
 
+/*
+ * Contribution of one entry to the content sum.  Entries are added and
+ * removed independently, so the sum depends only on what is in the map,
+ * not on the order it was loaded in.
+ */
+static inline unsigned long unipair_hash(u_short unicode, u_short fontpos)
+{
+	return hash_long(((unsigned long)fontpos << 16) | unicode, BITS_PER_LONG);
+}
+
 static int
 con_insert_unipair(struct uni_pagedir *p, u_short unicode, u_short fontpos)
 {
-	int i, n;
+	int i, n, old;
 	u16 **p1, *p2;
 
 	if (!(p1 = p->uni_pgdir[n = unicode >> 11])) {
@@ -429,9 +570,45 @@ con_insert_unipair(struct uni_pagedir *p, u_short unicode, u_short fontpos)
 		memset(p2, 0xff, 64*sizeof(u16)); /* No glyphs for the characters (yet) */
 	}
 
+	old = p2[unicode & 0x3f];
+	if (old == fontpos)
+		return 0;
+	if (old != 0xffff)
+		p->sum -= unipair_hash(unicode, old);
 	p2[unicode & 0x3f] = fontpos;
+
+	if (p->uni_cache) {
+		struct uni_cache_entry *e;
+
+		e = p->uni_cache + hash_long(unicode, UNI_CACHE_BITS);
+		if (e->ucs == unicode)
+			e->ucs = 0;
+	}
 	
-	p->sum += (fontpos << 20) + unicode;
+	p->sum += unipair_hash(unicode, fontpos);
+
+	/*
+	 * Patch the inverse tables that are built and show this code
+	 * point; only the glyph it left and the one it moved to change.
+	 * Big loads have dropped them all, so check for none at once.
+	 */
+	if (!p->inverse_translations[0] && !p->inverse_translations[1] &&
+	    !p->inverse_translations[2] && !p->inverse_translations[3])
+		return 0;
+	for (i = 0; i < 4; i++) {
+		unsigned short *t = translations[i];
+
+		if (!p->inverse_translations[i])
+			continue;
+		for (n = 0; n < E_TABSZ && t[n] != unicode; n++)
+			;
+		if (n == E_TABSZ)
+			continue;
+		if (old < MAX_GLYPH)
+			update_inverse_glyph(p, i, old);
+		if (fontpos < MAX_GLYPH)
+			update_inverse_glyph(p, i, fontpos);
+	}
 
 	return 0;
 }
@@ -495,23 +672,25 @@ int con_set_unimap(struct vc_data *vc, ushort ct, struct unipair __user *list)
 					}
               			}
               	p = q;
-	} else if (p == dflt)
-		dflt = NULL;
+	} else {
+		if (p == dflt)
+			dflt = NULL;
+		hlist_del_init(&p->hash_node);
+	}
 	
+	con_flush_glyphs(p);
+	if (ct > INVERSE_DELTA_MAX)
+		con_flush_inverse(p);
 	while (ct--) {
 		unsigned short unicode, fontpos;
 		__get_user(unicode, &list->unicode);
 		__get_user(fontpos, &list->fontpos);
 		if ((err1 = con_insert_unipair(p, unicode,fontpos)) != 0)
 			err = err1;
-			list++;
+		list++;
 	}
 	
-	if (con_unify_unimap(vc, p))
-		return err;
-
-	for (i = 0; i <= 3; i++)
-		set_inverse_transl(vc, p, i); /* Update all inverse translations */
+	con_unify_unimap(vc, p);
 	return err;
 }
 
@@ -532,7 +711,7 @@ int con_set_default_unimap(struct vc_data *vc)
 			return 0;
 		dflt->refcount++;
 		*vc->vc_uni_pagedir_loc = (unsigned long)dflt;
-		if (p && --p->refcount) {
+		if (p && !--p->refcount) {
 			con_release_unimap(p);
 			kfree(p);
 		}
@@ -558,8 +737,6 @@ int con_set_default_unimap(struct vc_data *vc)
 		return err;
 	}
 
-	for (i = 0; i <= 3; i++)
-		set_inverse_transl(vc, p, i);	/* Update all inverse translations */
 	dflt = p;
 	return err;
 }
@@ -615,17 +792,26 @@ void con_protect_unimap(struct vc_data *vc, int rdonly)
 	if (p) p->readonly = rdonly;
 }
 
-int
-conv_uni_to_pc(struct vc_data *vc, long ucs) 
+static int uni_lookup(struct uni_pagedir *p, long ucs)
 {
-	int h;
 	u16 **p1, *p2;
-	struct uni_pagedir *p;
+	int h;
+
+	if (ucs <= 0xffff &&
+	    (p1 = p->uni_pgdir[ucs >> 11]) &&
+	    (p2 = p1[(ucs >> 6) & 0x1f]) &&
+	    (h = p2[ucs & 0x3f]) < MAX_GLYPH)
+		return h;
+
+	return -4;		/* not found */
+}
+
+static int uni_to_glyph(struct uni_pagedir *p, long ucs)
+{
+	struct uni_cache_entry *e;
+	int h;
   
-	/* Only 16-bit codes supported at this time */
-	if (ucs > 0xffff)
-		ucs = 0xfffd;		/* U+FFFD: REPLACEMENT CHARACTER */
-	else if (ucs < 0x20 || ucs >= 0xfffe)
+	if (ucs < 0x20 || ucs == 0xfffe || ucs == 0xffff)
 		return -1;		/* Not a printable character */
 	else if (ucs == 0xfeff || (ucs >= 0x200a && ucs <= 0x200f))
 		return -2;			/* Zero-width space */
@@ -637,16 +823,38 @@ conv_uni_to_pc(struct vc_data *vc, long ucs)
 	else if ((ucs & ~UNI_DIRECT_MASK) == UNI_DIRECT_BASE)
 		return ucs & UNI_DIRECT_MASK;
   
-	if (!*vc->vc_uni_pagedir_loc)
+	if (!p)
 		return -3;
 
-	p = (struct uni_pagedir *)*vc->vc_uni_pagedir_loc;  
-	if ((p1 = p->uni_pgdir[ucs >> 11]) &&
-	    (p2 = p1[(ucs >> 6) & 0x1f]) &&
-	    (h = p2[ucs & 0x3f]) < MAX_GLYPH)
-		return h;
+	/*
+	 * Beyond Unicode: let the caller fall back to U+FFFD.  Astral
+	 * code points are looked up like any other; the unimap loaded
+	 * through PIO_UNIMAP only holds the BMP, so they miss for now.
+	 */
+	if (ucs > UNI_MAX)
+		return -4;
+
+	if (!p->uni_cache) {
+		p->uni_cache = kmalloc(UNI_CACHE_SIZE * sizeof(*e), GFP_ATOMIC);
+		if (!p->uni_cache)
+			return uni_lookup(p, ucs);
+		memset(p->uni_cache, 0, UNI_CACHE_SIZE * sizeof(*e));
+	}
 
-	return -4;		/* not found */
+	e = p->uni_cache + hash_long(ucs, UNI_CACHE_BITS);
+	if (e->ucs == ucs)
+		return e->glyph;
+
+	h = uni_lookup(p, ucs);
+	e->ucs = ucs;
+	e->glyph = h;
+	return h;
+}
+
+int
+conv_uni_to_pc(struct vc_data *vc, long ucs) 
+{
+	return uni_to_glyph((struct uni_pagedir *)*vc->vc_uni_pagedir_loc, ucs);
 }
 
 /*
@@ -26,7 +26,6 @@
 #include <linux/module.h>
 #include <linux/sched.h>
 #include <linux/tty.h>
-#include <linux/tty_flip.h>
 #include <linux/kernel.h>
 #include <linux/string.h>
 #include <linux/errno.h>
@@ -206,21 +205,20 @@ void vte_ed(struct vc_data *vc, int vpar)
 		count = (vc->vc_scr_end - vc->vc_pos) >> 1;
 		start = (unsigned short *) vc->vc_pos;
 		/* do in two stages */
-		clear_region(vc, vc->vc_x, vc->vc_y, vc->vc_cols - vc->vc_x, 1);
-		clear_region(vc, 0, vc->vc_y + 1, vc->vc_cols,
-				vc->vc_rows - vc->vc_y - 1);
+		vc_damage(vc, vc->vc_y, vc->vc_x, vc->vc_cols - vc->vc_x);
+		vc_damage_lines(vc, vc->vc_y + 1, vc->vc_rows);
 		break;
 	case 1:		/* erase from start to cursor */
 		count = ((vc->vc_pos - vc->vc_origin) >> 1) + 1;
 		start = (unsigned short *) vc->vc_origin;
 		/* do in two stages */
-		clear_region(vc, 0, 0, vc->vc_cols, vc->vc_y);
-		clear_region(vc, 0, vc->vc_y, vc->vc_x + 1, 1);
+		vc_damage_lines(vc, 0, vc->vc_y);
+		vc_damage(vc, vc->vc_y, 0, vc->vc_x + 1);
 		break;
 	case 2:		/* erase whole display */
 		count = vc->vc_cols * vc->vc_rows;
 		start = (unsigned short *) vc->vc_origin;
-		clear_region(vc, 0, 0, vc->vc_cols, vc->vc_rows);
+		vc_damage_lines(vc, 0, vc->vc_rows);
 		break;
 	default:
 		return;
@@ -241,17 +239,17 @@ static void vte_el(struct vc_data *vc, int vpar)
 	case 0:		/* erase from cursor to end of line */
 		count = vc->vc_cols - vc->vc_x;
 		start = (unsigned short *) vc->vc_pos;
-		clear_region(vc, vc->vc_x, vc->vc_y, vc->vc_cols - vc->vc_x, 1);
+		vc_damage(vc, vc->vc_y, vc->vc_x, vc->vc_cols - vc->vc_x);
 		break;
 	case 1:		/* erase from start of line to cursor */
 		start = (unsigned short *) (vc->vc_pos - (vc->vc_x << 1));
 		count = vc->vc_x + 1;
-		clear_region(vc, 0, vc->vc_y, vc->vc_x + 1, 1);
+		vc_damage(vc, vc->vc_y, 0, vc->vc_x + 1);
 		break;
 	case 2:		/* erase whole line */
 		start = (unsigned short *) (vc->vc_pos - (vc->vc_x << 1));
 		count = vc->vc_cols;
-		clear_region(vc, 0, vc->vc_y, vc->vc_cols, 1);
+		vc_damage(vc, vc->vc_y, 0, vc->vc_cols);
 		break;
 	default:
 		return;
@@ -273,7 +271,7 @@ static void vte_ech(struct vc_data *vc, int vpar)
 		vpar++;
 	count = (vpar > vc->vc_cols - vc->vc_x) ? (vc->vc_cols - vc->vc_x) : vpar;
 	scr_memsetw((unsigned short *) vc->vc_pos, vc->vc_video_erase_char, 2 * count);
-	clear_region(vc, vc->vc_x, vc->vc_y, count, 1);
+	vc_damage(vc, vc->vc_y, vc->vc_x, count);
 	vc->vc_need_wrap = 0;
 }
 
@@ -386,9 +384,8 @@ static void vte_sgr(struct vc_data *vc)
 /*
  * Fake a DEC DSR for non-implemented features
  */
-static void vte_fake_dec_dsr(struct tty_struct *tty, char *reply)
+static void vte_fake_dec_dsr(struct vc_data *vc, char *reply)
 {
-	struct vc_data *vc = (struct vc_data *) tty->driver_data;
 	char buf[40];
 
 	sprintf(buf, "%s?%sn", __VTE_CSI, reply);
@@ -399,9 +396,8 @@ static void vte_fake_dec_dsr(struct tty_struct *tty, char *reply)
  * CURSOR POSITION REPORT (CPR)
  * DEC EXTENDED CURSOR POSITION REPORT (DECXCPR)
  */
-static void vte_cpr(struct tty_struct *tty, int ext)
+static void vte_cpr(struct vc_data *vc, int ext)
 {
-	struct vc_data *vc = (struct vc_data *) tty->driver_data;
 	char buf[40];
 
 	if (ext) {
@@ -421,9 +417,8 @@ static void vte_cpr(struct tty_struct *tty, int ext)
 /*
  * DEVICE STATUS REPORT (DSR)
  */
-static inline void vte_dsr(struct tty_struct *tty)
+static inline void vte_dsr(struct vc_data *vc)
 {
-	struct vc_data *vc = (struct vc_data *) tty->driver_data;
 	char buf[40];
 
 	sprintf(buf, "%s0n", __VTE_CSI);
@@ -433,19 +428,16 @@ static inline void vte_dsr(struct tty_struct *tty)
 /*
  * ANSWERBACK MESSAGE
  */
-static inline void vte_answerback(struct tty_struct *tty)
+static inline void vte_answerback(struct vc_data *vc)
 {
-	struct vc_data *vc = (struct vc_data *) tty->driver_data;
-	
 	puts_queue(vc, "linux");
 }
 
 /*
  * DA - DEVICE ATTRIBUTE
  */
-static inline void vte_da(struct tty_struct *tty)
+static inline void vte_da(struct vc_data *vc)
 {
-	struct vc_data *vc = (struct vc_data *) tty->driver_data;
 	char buf[40];
 
 	/* We claim VT220 compatibility... */
@@ -462,9 +454,8 @@ static inline void vte_da(struct tty_struct *tty)
  * 2 = Firmware version (nn = n.n)
  * 3 = Installed options (0 = none)
  */
-static void vte_dec_da2(struct tty_struct *tty)
+static void vte_dec_da2(struct vc_data *vc)
 {
-	struct vc_data *vc = (struct vc_data *) tty->driver_data;
 	char buf[40];
 
 	sprintf(buf, "%s>%d;%d;0c", __VTE_CSI, 1, VTE_VERSION / 10);
@@ -476,9 +467,8 @@ static void vte_dec_da2(struct tty_struct *tty)
  *
  * Reply: unit ID (we report "0")
  */
-static void vte_dec_da3(struct tty_struct *tty)
+static void vte_dec_da3(struct vc_data *vc)
 {
-	struct vc_data *vc = (struct vc_data *) tty->driver_data;
 	char buf[40];
 
 	sprintf(buf, "%s!|%s%s", __VTE_DCS, "0", __VTE_ST);
@@ -488,9 +478,8 @@ static void vte_dec_da3(struct tty_struct *tty)
 /*
  * DECREPTPARM - DEC REPORT TERMINAL PARAMETERS [VT1xx/VT2xx/VT320]
  */
-static void vte_decreptparm(struct tty_struct *tty)
+static void vte_decreptparm(struct vc_data *vc)
 {
-	struct vc_data *vc = (struct vc_data *) tty->driver_data;
 	char buf[40];
 
 	sprintf(buf, "\033[%d;1;1;120;120;1;0x", vc->vc_par[0] + 2);
@@ -603,7 +592,7 @@ static void set_mode(struct vc_data *vc, int on_off)
 /*
  * DECCIR - Cursor information report
  */
-static void vte_deccir(struct tty_struct *tty)
+static void vte_deccir(struct vc_data *vc)
 {
 	/* not yet implemented */
 }
@@ -611,9 +600,8 @@ static void vte_deccir(struct tty_struct *tty)
 /*
  * DECMSR - Macro space report
  */
-static void vte_decmsr(struct tty_struct *tty)
+static void vte_decmsr(struct vc_data *vc)
 {
-	struct vc_data *vc = (struct vc_data *) tty->driver_data;
 	char buf[40];
 
 	sprintf(buf, "%s%d*{", __VTE_CSI, 0);	/* No space left */
@@ -623,10 +611,9 @@ static void vte_decmsr(struct tty_struct *tty)
 /*
  * DECRPM - Report mode
  */
-static void vte_decrpm(struct tty_struct *tty, int priv, int mode,
+static void vte_decrpm(struct vc_data *vc, int priv, int mode,
 		       int status)
 {
-	struct vc_data *vc = (struct vc_data *) tty->driver_data;
 	char buf[40];
 
 	if (status == 0) {
@@ -654,67 +641,65 @@ static void vte_decrpm(struct tty_struct *tty, int priv, int mode,
  * 3 = premanently set
  * 4 = permanently reset
  */
-static void vte_decrqm(struct tty_struct *tty, int priv)
+static void vte_decrqm(struct vc_data *vc, int priv)
 {
-	struct vc_data *vc = (struct vc_data *) tty->driver_data;
-
 	if (priv) {
 		switch (vc->vc_par[0]) {
 		case 1:	/* DECCKM - Cursor keys mode */
-			vte_decrpm(tty, priv, vc->vc_par[0], vc->vc_decckm);
+			vte_decrpm(vc, priv, vc->vc_par[0], vc->vc_decckm);
 			break;
 		case 2:	/* DECANM */
 		case 3:	/* DECCOLM */
 		case 4:	/* DECSCLM */
-			vte_decrpm(tty, priv, vc->vc_par[0], 4);
+			vte_decrpm(vc, priv, vc->vc_par[0], 4);
 			break;
 		case 5:	/* DECSCNM */
-			vte_decrpm(tty, priv, vc->vc_par[0], vc->vc_decscnm);
+			vte_decrpm(vc, priv, vc->vc_par[0], vc->vc_decscnm);
 			break;
 		case 6:	/* DECOM */
-			vte_decrpm(tty, priv, vc->vc_par[0], vc->vc_decom);
+			vte_decrpm(vc, priv, vc->vc_par[0], vc->vc_decom);
 			break;
 		case 7:	/* DECAWM */
-			vte_decrpm(tty, priv, vc->vc_par[0], vc->vc_decawm);
+			vte_decrpm(vc, priv, vc->vc_par[0], vc->vc_decawm);
 			break;
 		case 8:	/* DECARM */
-			vte_decrpm(tty, priv, vc->vc_par[0], vc->vc_decarm);
+			vte_decrpm(vc, priv, vc->vc_par[0], vc->vc_decarm);
 			break;
 		case 25:	/* DECTCEM */
-			vte_decrpm(tty, priv, vc->vc_par[0], vc->vc_dectcem);
+			vte_decrpm(vc, priv, vc->vc_par[0], vc->vc_dectcem);
 			break;
 		case 42:	/* DECNCRM */
 		case 60:	/* DECHCCM */
 		case 61:	/* DECVCCM */
 		case 64:	/* DECPCCM */
-			vte_decrpm(tty, priv, vc->vc_par[0], 4);
+			vte_decrpm(vc, priv, vc->vc_par[0], 4);
 			break;
 		case 66:	/* DECNKM */
-			vte_decrpm(tty, priv, vc->vc_par[0], vc->vc_decnkm);
+			vte_decrpm(vc, priv, vc->vc_par[0], vc->vc_decnkm);
 			break;
 		case 67:	/* DECBKM */
 		case 68:	/* DECKBUM */
 		case 69:	/* DECVSSM */
 		case 73:	/* DECXRLM */
 		case 81:	/* DECKPM */
-			vte_decrpm(tty, priv, vc->vc_par[0], 4);
+			vte_decrpm(vc, priv, vc->vc_par[0], 4);
 			break;
 		default:
-			vte_decrpm(tty, priv, vc->vc_par[0], 2);
+			vte_decrpm(vc, priv, vc->vc_par[0], 2);
 		}
 	} else {
 		switch (vc->vc_par[0]) {
 		case 1:	/* GATM */
-			vte_decrpm(tty, priv, vc->vc_par[0], 4);
+			vte_decrpm(vc, priv, vc->vc_par[0], 4);
 			break;
 		case 2:	/* KAM */
-			vte_decrpm(tty, priv, vc->vc_par[0], vc->vc_kam);
+			vte_decrpm(vc, priv, vc->vc_par[0], vc->vc_kam);
 			break;
 		case 3:	/* CRM */
-			vte_decrpm(tty, priv, vc->vc_par[0], 4);
+			vte_decrpm(vc, priv, vc->vc_par[0], 4);
 			break;
 		case 4:	/* IRM */
-			vte_decrpm(tty, priv, vc->vc_par[0], vc->vc_irm);
+			vte_decrpm(vc, priv, vc->vc_par[0], vc->vc_irm);
 			break;
 		case 5:	/* SRTM */
 		case 6:	/* ERM */
@@ -731,17 +716,17 @@ static void vte_decrqm(struct tty_struct *tty, int priv)
 		case 17:	/* SATM */
 		case 18:	/* TSM */
 		case 19:	/* EBM */
-			vte_decrpm(tty, priv, vc->vc_par[0], 4);
+			vte_decrpm(vc, priv, vc->vc_par[0], 4);
 			break;
 		case 20:	/* LNM */
-			vte_decrpm(tty, priv, vc->vc_par[0], vc->vc_lnm);
+			vte_decrpm(vc, priv, vc->vc_par[0], vc->vc_lnm);
 			break;
 		case 21:	/* GRCM */
 		case 22:	/* ZDM */
-			vte_decrpm(tty, priv, vc->vc_par[0], 4);
+			vte_decrpm(vc, priv, vc->vc_par[0], 4);
 			break;
 		default:
-			vte_decrpm(tty, priv, vc->vc_par[0], 2);
+			vte_decrpm(vc, priv, vc->vc_par[0], 2);
 		}
 	}
 }
@@ -776,7 +761,7 @@ static void vte_decscl(struct vc_data *vc)
 /*
  * DECTABSR - Tabulation stop report
  */
-void vte_dectabsr(struct tty_struct *tty)
+void vte_dectabsr(struct vc_data *vc)
 {
 	/* not yet implemented */
 }
@@ -784,7 +769,7 @@ void vte_dectabsr(struct tty_struct *tty)
 /*
  * DECTSR - Terminal state report
  */
-void vte_dectsr(struct tty_struct *tty)
+void vte_dectsr(struct vc_data *vc)
 {
 	/* not yet implemented */
 }
@@ -1007,7 +992,7 @@ void vte_ris(struct vc_data *vc, int do_clear)
 	    vc->kbd_table.default_ledflagstate = KBD_DEFLEDS;
 	vc->kbd_table.modeflags = KBD_DEFMODE;
 	vc->kbd_table.kbdmode = VC_XLATE;
-	set_leds();
+	set_leds(vc);
 
 	vc->vc_cursor_type = CUR_DEFAULT;
 	vc->vc_complement_mask = vc->vc_s_complement_mask;
@@ -1069,7 +1054,7 @@ static void vte_tbc(struct vc_data *vc, int vpar)
 	}
 }
 
-void terminal_emulation(struct tty_struct *tty, int c)
+void terminal_emulation(struct vc_data *vc, int c)
 {
 	/*
 	 * C0 CONTROL CHARACTERS
@@ -1077,8 +1062,6 @@ void terminal_emulation(struct tty_struct *tty, int c)
 	 * NOTE: Control characters can be used in the _middle_
 	 *       of an escape sequence.  (XXX: Really? Test!)
 	 */
-	struct vc_data *vc = (struct vc_data *) tty->driver_data;
-
 	switch (c) {
 	case 0x00:		/* NUL - Null */
 	case 0x01:		/* SOH - Start of header */
@@ -1087,7 +1070,7 @@ void terminal_emulation(struct tty_struct *tty, int c)
 	case 0x04:		/* EOT - End of transmission */
 		return;
 	case 0x05:		/* ENQ - Enquiry */
-		vte_answerback(tty);
+		vte_answerback(vc);
 		return;
 	case 0x06:		/* ACK - Acknowledge */
 		return;
@@ -1152,6 +1135,7 @@ void terminal_emulation(struct tty_struct *tty, int c)
 		vc->vc_state = ESinit;
 		return;
 	case 0x1b:		/* ESC - Escape */
+		vc->vc_stats.escapes++;
 		vc->vc_state = ESesc;
 		return;
 	case 0x1c:		/* IS4 - */
@@ -1224,10 +1208,11 @@ void terminal_emulation(struct tty_struct *tty, int c)
 			return;
 		case 0x9a:	/* SCI - Single character introducer */
 #ifndef VTE_STRICT_ISO
-			vte_da(tty);
+			vte_da(vc);
 #endif				/* ndef VTE_STRICT_ISO */
 			return;
 		case 0x9b:	/* CSI - Control sequence introducer */
+			vc->vc_stats.escapes++;
 			vc->vc_state = EScsi;
 			return;
 		case 0x9c:	/* ST  - String Terminator */
@@ -1350,7 +1335,7 @@ void terminal_emulation(struct tty_struct *tty, int c)
 			return;
 		case 'Z':	/* SCI - Single character introducer */
 #ifndef VTE_STRICT_ISO
-			vte_da(tty);
+			vte_da(vc);
 #endif				/* ndef VTE_STRICT_ISO */
 			return;
 		case '[':	/* CSI - Control sequence introducer */
@@ -1513,13 +1498,13 @@ void terminal_emulation(struct tty_struct *tty, int c)
 		case 'c':
 			if (vc->vc_priv2) {
 				if (!vc->vc_par[0])
-					vte_dec_da3(tty);
+					vte_dec_da3(vc);
 				vc->vc_priv2 = 0;
 				return;
 			}
 			if (vc->vc_priv3) {
 				if (!vc->vc_par[0])
-					vte_dec_da2(tty);
+					vte_dec_da2(vc);
 				vc->vc_priv3 = 0;
 				return;
 			}
@@ -1534,7 +1519,8 @@ void terminal_emulation(struct tty_struct *tty, int c)
 			break;
 		case 'm':
 			if (vc->vc_priv4) {
-				clear_selection();
+				if (vc == sel_cons)
+					clear_selection();
 				if (vc->vc_par[0])
 					vc->vc_complement_mask =
 					    vc->vc_par[0] << 8 | vc->vc_par[1];
@@ -1549,37 +1535,37 @@ void terminal_emulation(struct tty_struct *tty, int c)
 			if (vc->vc_priv4) {
 				switch (vc->vc_par[0]) {
 				case 6:	/* DECXCPR - Extended CPR */
-					vte_cpr(tty, 1);
+					vte_cpr(vc, 1);
 					break;
 				case 15:	/* DEC printer status */
-					vte_fake_dec_dsr(tty, "13");
+					vte_fake_dec_dsr(vc, "13");
 					break;
 				case 25:	/* DEC UDK status */
-					vte_fake_dec_dsr(tty, "21");
+					vte_fake_dec_dsr(vc, "21");
 					break;
 				case 26:	/* DEC keyboard status */
-					vte_fake_dec_dsr(tty, "27;1;0;1");
+					vte_fake_dec_dsr(vc, "27;1;0;1");
 					break;
 				case 53:	/* DEC locator status */
-					vte_fake_dec_dsr(tty, "53");
+					vte_fake_dec_dsr(vc, "53");
 					break;
 				case 62:	/* DEC macro space */
-					vte_decmsr(tty);
+					vte_decmsr(vc);
 					break;
 				case 75:	/* DEC data integrity */
-					vte_fake_dec_dsr(tty, "70");
+					vte_fake_dec_dsr(vc, "70");
 					break;
 				case 85:	/* DEC multiple session status */
-					vte_fake_dec_dsr(tty, "83");
+					vte_fake_dec_dsr(vc, "83");
 					break;
 				}
 			} else
 				switch (vc->vc_par[0]) {
 				case 5:	/* DSR - Device status report */
-					vte_dsr(tty);
+					vte_dsr(vc);
 					break;
 				case 6:	/* CPR - Cursor position report */
-					vte_cpr(tty, 0);
+					vte_cpr(vc, 0);
 					break;
 				}
 			vc->vc_priv4 = 0;
@@ -1722,7 +1708,7 @@ void terminal_emulation(struct tty_struct *tty, int c)
 			return;
 		case 'c':	/* DA - Device attribute */
 			if (!vc->vc_par[0])
-				vte_da(tty);
+				vte_da(vc);
 			return;
 		case 'd':	/* VPA - Line position absolute */
 			if (vc->vc_par[0])
@@ -1766,7 +1752,7 @@ void terminal_emulation(struct tty_struct *tty, int c)
 		case 't':	/* DECSLPP - Set lines per page */
 			return;
 		case 'x':	/* DECREQTPARM - Request terminal parameters */
-			vte_decreptparm(tty);
+			vte_decreptparm(vc);
 			return;
 		case 'y':
 			if (vc->vc_par[0] == 4) {
@@ -1822,7 +1808,7 @@ void terminal_emulation(struct tty_struct *tty, int c)
 		vc->vc_state = ESinit;
 		switch (c) {
 		case 'p':	/* DECRQM - Request mode */
-			vte_decrqm(tty, vc->vc_priv4);
+			vte_decrqm(vc, vc->vc_priv4);
 			return;
 		case 'r':	/* DECCARA - Change attributes in rectangular area */
 			return;
@@ -1830,17 +1816,17 @@ void terminal_emulation(struct tty_struct *tty, int c)
 			return;
 		case 'u':	/* DECRQTSR - Request terminal state */
 			if (vc->vc_par[0] == 1)
-				vte_dectsr(tty);
+				vte_dectsr(vc);
 			return;
 		case 'v':	/* DECCRA - Copy rectangular area */
 			return;
 		case 'w':	/* DECRQPSR - Request presentation status */
 			switch (vc->vc_par[0]) {
 			case 1:
-				vte_deccir(tty);
+				vte_deccir(vc);
 				break;
 			case 2:
-				vte_dectabsr(tty);
+				vte_dectabsr(vc);
 				break;
 			}
 			return;
@@ -1932,7 +1918,6 @@ void terminal_emulation(struct tty_struct *tty, int c)
 			vc->vc_video_erase_char = (vc->vc_video_erase_char & 0xff00) | 'E';
 			vte_ed(vc, 2);
 			vc->vc_video_erase_char = (vc->vc_video_erase_char & 0xff00) | ' ';
-			do_update_region(vc, vc->vc_origin, vc->vc_screenbuf_size / 2);
 		}
 		return;
 	case ESgzd4:
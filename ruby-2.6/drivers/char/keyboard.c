@@ -41,7 +41,7 @@
 
 static void kbd_disconnect(struct input_handle *handle);
 extern void ctrl_alt_del(void);
-void compute_shiftstate(void);
+void compute_shiftstate(struct vt_struct *vt);
 
 /*
  * Handler Tables.
@@ -83,23 +83,11 @@ const int max_vals[] = {
 const int NR_TYPES = ARRAY_SIZE(max_vals);
 int spawnpid, spawnsig;
 
-/*
- * Variables exported for vt.c
- */
-
-int shift_state = 0;
-
 /*
  * Internal Data.
  */
 
 static struct input_handler kbd_handler;
-static unsigned long key_down[NBITS(KEY_MAX)];		/* keyboard key bitmap */
-static unsigned char shift_down[NR_SHIFT];		/* shift state counters.. */
-static int dead_key_next;
-static int npadch = -1;					/* -1 or number assembled on pad */
-static unsigned char diacr;
-static char rep;					/* flag telling character repeat */
 
 static struct ledptr {
 	unsigned int *addr;
@@ -118,9 +106,7 @@ unsigned char kbd_sysrq_xlate[KEY_MAX + 1] =
         "\206\207\210\211\212\000\000789-456+1"         /* 0x40 - 0x4f */
         "230\177\000\000\213\214\000\000\000\000\000\000\000\000\000\000" /* 0x50 - 0x5f */
         "\r\000/";                                      /* 0x60 - 0x6f */
-static int sysrq_down;
 #endif
-static int sysrq_alt;
 
 /*
  * Translation of scancodes to keycodes. We set them on only the first attached
@@ -226,16 +212,92 @@ int kbd_rate(struct input_handle *handle, struct kbd_repeat *rep)
 /*
  * Helper Functions.
  */
+
+/*
+ * Keyboard input goes into the flip buffer as it is decoded, but the
+ * flip work is only kicked once per input report (EV_SYN), so a burst
+ * of keys costs one work item rather than one per byte.  The start of
+ * a burst schedules kbd_bh(), which pushes whatever a device that never
+ * syncs leaves behind.
+ */
+static spinlock_t kbd_pending_lock = SPIN_LOCK_UNLOCKED;
+
+/* Called with kbd_pending_lock held */
+static void __kbd_push(struct vt_struct *vt)
+{
+	struct vc_data *vc = vt->kbd_pending;
+
+	vt->kbd_pending = NULL;
+	if (vc && vc->vc_tty)
+		tty_flip_buffer_push(vc->vc_tty);
+}
+
+static void kbd_push(struct vt_struct *vt)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&kbd_pending_lock, flags);
+	__kbd_push(vt);
+	spin_unlock_irqrestore(&kbd_pending_lock, flags);
+}
+
+static void kbd_queued(struct vc_data *vc)
+{
+	struct vt_struct *vt = vc->display_fg;
+	unsigned long flags;
+
+	if (vt->kbd_pending == vc)
+		return;
+	spin_lock_irqsave(&kbd_pending_lock, flags);
+	if (vt->kbd_pending != vc) {
+		__kbd_push(vt);
+		vt->kbd_pending = vc;
+		tasklet_schedule(&keyboard_tasklet);
+	}
+	spin_unlock_irqrestore(&kbd_pending_lock, flags);
+}
+
+/*
+ * vt_close() and vc_disallocate() call this before the tty or the VC
+ * goes away, so that kbd_push() cannot find it pending afterwards.
+ * Whatever was queued and not pushed yet is dropped with the tty.
+ */
+void kbd_drop_pending(struct vc_data *vc)
+{
+	struct vt_struct *vt = vc->display_fg;
+	unsigned long flags;
+
+	spin_lock_irqsave(&kbd_pending_lock, flags);
+	if (vt->kbd_pending == vc)
+		vt->kbd_pending = NULL;
+	spin_unlock_irqrestore(&kbd_pending_lock, flags);
+}
+
 static void put_queue(struct vc_data *vc, int ch)
 {
 	struct tty_struct *tty = vc->vc_tty;
 
 	if (tty) {
 		tty_insert_flip_char(tty, ch, 0);
-		schedule_work(&tty->flip.work);
+		kbd_queued(vc);
+	}
+}
+
+static void kbd_puts_queue(struct vc_data *vc, char *cp)
+{
+	struct tty_struct *tty = vc->vc_tty;
+
+	if (!tty)
+		return;
+
+	while (*cp) {
+		tty_insert_flip_char(tty, *cp, 0);
+		cp++;
 	}
+	kbd_queued(vc);
 }
 
+/* For replies from the terminal emulation, which are not followed by a sync */
 void puts_queue(struct vc_data *vc, char *cp)
 {
 	struct tty_struct *tty = vc->vc_tty;
@@ -256,7 +318,7 @@ static void applkey(struct vc_data *vc, int key, char mode)
 
 	buf[1] = (mode ? 'O' : '[');
 	buf[2] = key;
-	puts_queue(vc, buf);
+	kbd_puts_queue(vc, buf);
 }
 
 /*
@@ -286,38 +348,32 @@ static void to_utf8(struct vc_data *vc, ushort c)
 /* 
  * Called after returning from RAW mode or when changing consoles - recompute
  * shift_down[] and shift_state from key_down[] maybe called when keymap is
- * undefined, so that shiftkey release is seen
+ * undefined, so that shiftkey release is seen.  Only the keys that are
+ * actually down are visited, usually none or a few.
  */
-void compute_shiftstate(void)
+void compute_shiftstate(struct vt_struct *vt)
 {
-	unsigned int i, j, k, sym, val;
-
-	shift_state = 0;
-	memset(shift_down, 0, sizeof(shift_down));
-	
-	for (i = 0; i < ARRAY_SIZE(key_down); i++) {
-
-		if (!key_down[i])
-			continue;
-
-		k = i * BITS_PER_LONG;
+	struct kbd_state *kbd = &vt->kbd_state;
+	unsigned int k, n, sym, val;
 
-		for (j = 0; j < BITS_PER_LONG; j++, k++) {
+	kbd->shift_state = 0;
+	memset(kbd->shift_down, 0, sizeof(kbd->shift_down));
 
-			if (!test_bit(k, key_down))
-				continue;
+	for (n = kbd->keys_down, k = 0; n; n--, k++) {
+		k = find_next_bit(kbd->key_down, KEY_MAX + 1, k);
+		if (k > KEY_MAX)
+			break;
 
-			sym = U(key_maps[0][k]);
-			if (KTYP(sym) != KT_SHIFT && KTYP(sym) != KT_SLOCK)
-				continue;
+		sym = U(key_maps[0][k]);
+		if (KTYP(sym) != KT_SHIFT && KTYP(sym) != KT_SLOCK)
+			continue;
 
-			val = KVAL(sym);
-			if (val == KVAL(K_CAPSSHIFT))
-				val = KVAL(K_SHIFT);
+		val = KVAL(sym);
+		if (val == KVAL(K_CAPSSHIFT))
+			val = KVAL(K_SHIFT);
 
-			shift_down[val]++;
-			shift_state |= (1 << val);
-		}
+		kbd->shift_down[val]++;
+		kbd->shift_state |= (1 << val);
 	}
 }
 
@@ -330,10 +386,11 @@ void compute_shiftstate(void)
  */
 static unsigned char handle_diacr(struct vc_data *vc, unsigned char ch)
 {
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
 	unsigned int i;
-	int d = diacr;
+	int d = kbd->diacr;
 
-	diacr = 0;
+	kbd->diacr = 0;
 
 	for (i = 0; i < accent_table_size; i++) {
 		if (accent_table[i].diacr == d && accent_table[i].base == ch)
@@ -352,9 +409,11 @@ static unsigned char handle_diacr(struct vc_data *vc, unsigned char ch)
  */
 static void fn_enter(struct vc_data *vc)
 {
-	if (diacr) {
-		put_queue(vc, diacr);
-		diacr = 0;
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
+
+	if (kbd->diacr) {
+		put_queue(vc, kbd->diacr);
+		kbd->diacr = 0;
 	}
 	put_queue(vc, 13);
 	if (get_kbd_mode(&vc->kbd_table, VC_CRLF))
@@ -363,16 +422,22 @@ static void fn_enter(struct vc_data *vc)
 
 static void fn_caps_toggle(struct vc_data *vc)
 {
-	if (rep)
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
+
+	if (kbd->rep)
 		return;
 	chg_kbd_led(&vc->kbd_table, VC_CAPSLOCK);
+	set_leds(vc);
 }
 
 static void fn_caps_on(struct vc_data *vc)
 {
-	if (rep)
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
+
+	if (kbd->rep)
 		return;
 	set_kbd_led(&vc->kbd_table, VC_CAPSLOCK);
+	set_leds(vc);
 }
 
 static void fn_show_ptregs(struct vc_data *vc)
@@ -386,9 +451,10 @@ static void fn_show_ptregs(struct vc_data *vc)
 
 static void fn_hold(struct vc_data *vc)
 {
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
 	struct tty_struct *tty = vc->vc_tty;
 
-	if (rep || !tty)
+	if (kbd->rep || !tty)
 		return;
 
 	/*
@@ -418,8 +484,12 @@ static void fn_num(struct vc_data *vc)
  */
 static void fn_bare_num(struct vc_data *vc)
 {
-	if (!rep)
-		chg_kbd_led(&vc->kbd_table, VC_NUMLOCK);
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
+
+	if (kbd->rep)
+		return;
+	chg_kbd_led(&vc->kbd_table, VC_NUMLOCK);
+	set_leds(vc);
 }
 
 static void fn_lastcons(struct vc_data *vc)
@@ -467,7 +537,7 @@ static void fn_send_intr(struct vc_data *vc)
 	if (!tty)
 		return;
 	tty_insert_flip_char(tty, 0, TTY_BREAK);
-	schedule_work(&tty->flip.work);
+	kbd_queued(vc);
 }
 
 static void fn_scroll_forw(struct vc_data *vc)
@@ -497,7 +567,9 @@ static void fn_boot_it(struct vc_data *vc)
 
 static void fn_compose(struct vc_data *vc)
 {
-	dead_key_next = 1;
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
+
+	kbd->dead_key_next = 1;
 }
 
 static void fn_spawn_con(struct vc_data *vc)
@@ -522,7 +594,7 @@ static void fn_SAK(struct vc_data *vc)
 
 static void fn_null(struct vc_data *vc)
 {
-	compute_shiftstate();
+	compute_shiftstate(vc->display_fg);
 }
 
 /*
@@ -552,15 +624,17 @@ static void k_lowercase(struct vc_data *vc, unsigned char value, char up_flag)
 
 static void k_self(struct vc_data *vc, unsigned char value, char up_flag)
 {
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
+
 	if (up_flag)
 		return;		/* no action, if this is a key release */
 
-	if (diacr)
+	if (kbd->diacr)
 		value = handle_diacr(vc, value);
 
-	if (dead_key_next) {
-		dead_key_next = 0;
-		diacr = value;
+	if (kbd->dead_key_next) {
+		kbd->dead_key_next = 0;
+		kbd->diacr = value;
 		return;
 	}
 	put_queue(vc, value);
@@ -573,9 +647,11 @@ static void k_self(struct vc_data *vc, unsigned char value, char up_flag)
  */
 static void k_dead2(struct vc_data *vc, unsigned char value, char up_flag)
 {
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
+
 	if (up_flag)
 		return;
-	diacr = (diacr ? handle_diacr(vc, value) : value);
+	kbd->diacr = (kbd->diacr ? handle_diacr(vc, value) : value);
 }
 
 /*
@@ -606,7 +682,7 @@ static void k_fn(struct vc_data *vc, unsigned char value, char up_flag)
 	v = value;
 	if (v < ARRAY_SIZE(func_table)) {
 		if (func_table[value])
-			puts_queue(vc, func_table[value]);
+			kbd_puts_queue(vc, func_table[value]);
 	} else
 		printk(KERN_ERR "k_fn called with value=%d\n", value);
 }
@@ -622,6 +698,7 @@ static void k_cur(struct vc_data *vc, unsigned char value, char up_flag)
 
 static void k_pad(struct vc_data *vc, unsigned char value, char up_flag)
 {
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
 	static const char *pad_chars = "0123456789+-*/\015,.?()#";
 	static const char *app_map = "pqrstuvwxylSRQMnnmPQS";
 
@@ -629,7 +706,7 @@ static void k_pad(struct vc_data *vc, unsigned char value, char up_flag)
 		return;		/* no action, if this is a key release */
 
 	/* kludge... shift forces cursor/number keys */
-	if (get_kbd_mode(&vc->kbd_table, VC_APPLIC) && !shift_down[KG_SHIFT]) {
+	if (get_kbd_mode(&vc->kbd_table, VC_APPLIC) && !kbd->shift_down[KG_SHIFT]) {
 		applkey(vc, app_map[value], 1);
 		return;
 	}
@@ -679,9 +756,10 @@ static void k_pad(struct vc_data *vc, unsigned char value, char up_flag)
 
 static void k_shift(struct vc_data *vc, unsigned char value, char up_flag)
 {
-	int old_state = shift_state;
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
+	int old_state = kbd->shift_state;
 
-	if (rep)
+	if (kbd->rep)
 		return;
 	/*
 	 * Mimic typewriter:
@@ -689,8 +767,10 @@ static void k_shift(struct vc_data *vc, unsigned char value, char up_flag)
 	 */
 	if (value == KVAL(K_CAPSSHIFT)) {
 		value = KVAL(K_SHIFT);
-		if (!up_flag)
+		if (!up_flag) {
 			clr_kbd_led(&vc->kbd_table, VC_CAPSLOCK);
+			set_leds(vc);
+		}
 	}
 
 	if (up_flag) {
@@ -698,23 +778,23 @@ static void k_shift(struct vc_data *vc, unsigned char value, char up_flag)
 		 * handle the case that two shift or control
 		 * keys are depressed simultaneously
 		 */
-		if (shift_down[value])
-			shift_down[value]--;
+		if (kbd->shift_down[value])
+			kbd->shift_down[value]--;
 	} else
-		shift_down[value]++;
+		kbd->shift_down[value]++;
 
-	if (shift_down[value])
-		shift_state |= (1 << value);
+	if (kbd->shift_down[value])
+		kbd->shift_state |= (1 << value);
 	else
-		shift_state &= ~(1 << value);
+		kbd->shift_state &= ~(1 << value);
 
 	/* kludge */
-	if (up_flag && shift_state != old_state && npadch != -1) {
+	if (up_flag && kbd->shift_state != old_state && kbd->npadch != -1) {
 		if (vc->kbd_table.kbdmode == VC_UNICODE)
-			to_utf8(vc, npadch & 0xffff);
+			to_utf8(vc, kbd->npadch & 0xffff);
 		else
-			put_queue(vc, npadch & 0xff);
-		npadch = -1;
+			put_queue(vc, kbd->npadch & 0xff);
+		kbd->npadch = -1;
 	}
 }
 
@@ -732,6 +812,7 @@ static void k_meta(struct vc_data *vc, unsigned char value, char up_flag)
 
 static void k_ascii(struct vc_data *vc, unsigned char value, char up_flag)
 {
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
 	int base;
 
 	if (up_flag)
@@ -746,23 +827,27 @@ static void k_ascii(struct vc_data *vc, unsigned char value, char up_flag)
 		base = 16;
 	}
 
-	if (npadch == -1)
-		npadch = value;
+	if (kbd->npadch == -1)
+		kbd->npadch = value;
 	else
-		npadch = npadch * base + value;
+		kbd->npadch = kbd->npadch * base + value;
 }
 
 static void k_lock(struct vc_data *vc, unsigned char value, char up_flag)
 {
-	if (up_flag || rep)
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
+
+	if (up_flag || kbd->rep)
 		return;
 	chg_kbd_lock(&vc->kbd_table, value);
 }
 
 static void k_slock(struct vc_data *vc, unsigned char value, char up_flag)
 {
+	struct kbd_state *kbd = &vc->display_fg->kbd_state;
+
 	k_shift(vc, value, up_flag);
-	if (up_flag || rep)
+	if (up_flag || kbd->rep)
 		return;
 	chg_kbd_slock(&vc->kbd_table, value);
 	/* try to make Alt, oops, AltGr and such work */
@@ -789,7 +874,7 @@ void setledstate(struct vc_data *vc, unsigned int led)
 		vc->kbd_table.ledmode = LED_SHOW_IOCTL;
 	} else
 		vc->kbd_table.ledmode = LED_SHOW_FLAGS;
-	set_leds();
+	set_leds(vc);
 }
 
 void register_leds(struct kbd_struct *kbd, unsigned int led,
@@ -804,6 +889,29 @@ void register_leds(struct kbd_struct *kbd, unsigned int led,
 		kbd->ledmode = LED_SHOW_FLAGS;
 }
 
+/*
+ * VTs whose LEDs may be out of date.  kbd_bh() only looks at these,
+ * not at every keyboard attached.
+ */
+static LIST_HEAD(led_dirty);
+static spinlock_t led_lock = SPIN_LOCK_UNLOCKED;
+
+static void kbd_leds_dirty(struct vt_struct *vt)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&led_lock, flags);
+	if (list_empty(&vt->led_node))
+		list_add_tail(&vt->led_node, &led_dirty);
+	spin_unlock_irqrestore(&led_lock, flags);
+}
+
+void set_leds(struct vc_data *vc)
+{
+	kbd_leds_dirty(vc->display_fg);
+	tasklet_schedule(&keyboard_tasklet);
+}
+
 static inline unsigned char getleds(struct vc_data *vc)
 {
 	unsigned char leds;
@@ -826,6 +934,28 @@ static inline unsigned char getleds(struct vc_data *vc)
 	return leds;
 }
 
+/* Send the keyboard only the LEDs that changed */
+static void kbd_update_leds(struct vt_struct *vt)
+{
+	struct input_handle *handle = vt->keyboard;
+	unsigned char leds, changed;
+
+	if (!handle)
+		return;
+	leds = getleds(vt->fg_console);
+	changed = leds ^ vt->vt_ledstate;
+	if (!changed)
+		return;
+	if (changed & 0x01)
+		input_event(handle->dev, EV_LED, LED_SCROLLL, !!(leds & 0x01));
+	if (changed & 0x02)
+		input_event(handle->dev, EV_LED, LED_NUML,    !!(leds & 0x02));
+	if (changed & 0x04)
+		input_event(handle->dev, EV_LED, LED_CAPSL,   !!(leds & 0x04));
+	input_sync(handle->dev);
+	vt->vt_ledstate = leds;
+}
+
 /*
  * This routine is the bottom half of the keyboard interrupt
  * routine, and runs with all interrupts enabled. It does
@@ -842,25 +972,27 @@ static inline unsigned char getleds(struct vc_data *vc)
 
 static void kbd_bh(unsigned long dummy)
 {
-	struct list_head * node;
-	unsigned char leds;
+	int mem_leds = ledptrs[0].valid || ledptrs[1].valid || ledptrs[2].valid;
+	struct vt_struct *vt;
 
-	list_for_each(node, &kbd_handler.h_list) {
-		struct input_handle *handle = to_handle_h(node);
-		struct vt_struct *vt = handle->private;
+	list_for_each_entry(vt, &vt_list, node) {
+		kbd_push(vt);
+		/* LEDs that mirror kernel memory change without telling anyone */
+		if (mem_leds)
+			kbd_leds_dirty(vt);
+	}
 
-		if (vt) {
-			leds = getleds(vt->fg_console);
+	spin_lock_irq(&led_lock);
+	while (!list_empty(&led_dirty)) {
+		vt = list_entry(led_dirty.next, struct vt_struct, led_node);
+		list_del_init(&vt->led_node);
+		spin_unlock_irq(&led_lock);
 
-			if (leds != vt->vt_ledstate) {
-				input_event(handle->dev, EV_LED, LED_SCROLLL, !!(leds & 0x01));
-				input_event(handle->dev, EV_LED, LED_NUML,    !!(leds & 0x02));
-				input_event(handle->dev, EV_LED, LED_CAPSL,   !!(leds & 0x04));
-				input_sync(handle->dev);
-				vt->vt_ledstate = leds;
-			}
-		}
-	}	
+		kbd_update_leds(vt);
+
+		spin_lock_irq(&led_lock);
+	}
+	spin_unlock_irq(&led_lock);
 }
 
 DECLARE_TASKLET_DISABLED(keyboard_tasklet, kbd_bh, 0);
@@ -942,7 +1074,7 @@ static int emulate_raw(struct vc_data *vc, unsigned int keycode,
 			return 0;
 	} 
 
-	if (keycode == KEY_SYSRQ && sysrq_alt) {
+	if (keycode == KEY_SYSRQ && vc->display_fg->kbd_state.sysrq_alt) {
 		put_queue(vc, 0x54 | up_flag);
 		return 0;
 	}
@@ -982,12 +1114,69 @@ static void kbd_rawcode(struct vc_data *vc, unsigned char data)
 		put_queue(vc, data);
 }
 
+/*
+ * kbd_keycode() looks keys up in a compiled copy of each keymap: the
+ * first NR_KEYS entries as the keys read plainly, the next NR_KEYS as
+ * they read with CapsLock on, with KT_LETTER already folded to
+ * KT_LATIN in both.  A copy is rebuilt whenever KDSKBENT changes its
+ * map or the map it takes CapsLock letters from.
+ *
+ * kbd_keycode() runs in interrupt context, so a copy is never changed
+ * in place: the new one is built aside and swapped in under
+ * kbd_maps_lock, which the lookup holds, and the old one is freed once
+ * the swap is done.
+ */
+static unsigned short *kbd_maps[MAX_NR_KEYMAPS];
+static spinlock_t kbd_maps_lock = SPIN_LOCK_UNLOCKED;
+
+static void kbd_compile_map(int s)
+{
+	unsigned short *map = key_maps[s];
+	unsigned short *alt = key_maps[s ^ (1 << KG_SHIFT)];
+	unsigned short *q = NULL, *old;
+	unsigned long flags;
+	int k;
+
+	/* Without a copy kbd_keycode() uses the keymap itself */
+	if (map && (q = kmalloc(2 * NR_KEYS * sizeof(*q), GFP_KERNEL))) {
+		for (k = 0; k < NR_KEYS; k++) {
+			unsigned short sym = map[k];
+
+			if (KTYP(sym) == 0xf0 + KT_LETTER) {
+				q[k] = U(K(KT_LATIN, KVAL(sym)));
+				q[NR_KEYS + k] =
+					U(K(KT_LATIN, KVAL(alt ? alt[k] : sym)));
+			} else
+				q[k] = q[NR_KEYS + k] = sym;
+		}
+	}
+
+	spin_lock_irqsave(&kbd_maps_lock, flags);
+	old = kbd_maps[s];
+	kbd_maps[s] = q;
+	spin_unlock_irqrestore(&kbd_maps_lock, flags);
+	kfree(old);
+}
+
+/*
+ * Called after key_maps[s] changed.  Once it returns no kbd_keycode()
+ * is still looking at a keymap that was unhooked before the call, so
+ * the caller may free it.
+ */
+void kbd_keymap_changed(int s)
+{
+	kbd_compile_map(s);
+	kbd_compile_map(s ^ (1 << KG_SHIFT));
+}
+
 static void kbd_keycode(struct vt_struct *vt, unsigned int keycode, int down, int hw_raw)
 {
 	struct vc_data *vc = vt->fg_console;
-	unsigned short keysym, *key_map;
+	struct kbd_state *kbd = &vt->kbd_state;
+	unsigned short keysym = K_HOLE, *key_map, *kbd_map, *alt;
 	unsigned char type, raw_mode;
 	struct tty_struct *tty;
+	unsigned long flags;
 	int shift_final;
 
 	tty = vc->vc_tty;
@@ -998,13 +1187,13 @@ static void kbd_keycode(struct vt_struct *vt, unsigned int keycode, int down, in
 	}
 
 	if (keycode == KEY_LEFTALT || keycode == KEY_RIGHTALT)
-		sysrq_alt = down;
+		kbd->sysrq_alt = down;
 #if defined(CONFIG_SPARC32) || defined(CONFIG_SPARC64)
 	if (keycode == KEY_STOP)
 		sparc_l1_a_state = down;
 #endif
 
-	rep = (down == 2);
+	kbd->rep = (down == 2);
 
 #ifdef CONFIG_MAC_EMUMOUSEBTN
 	if (mac_hid_mouse_emulate_buttons(1, keycode, down))
@@ -1017,11 +1206,11 @@ static void kbd_keycode(struct vt_struct *vt, unsigned int keycode, int down, in
 				printk(KERN_WARNING "keyboard.c: can't emulate rawmode for keycode %d\n", keycode);
 
 #ifdef CONFIG_MAGIC_SYSRQ	       /* Handle the SysRq Hack */
-	if (keycode == KEY_SYSRQ && (sysrq_down || (down == 1 && sysrq_alt))) {
-		sysrq_down = down;
+	if (keycode == KEY_SYSRQ && (kbd->sysrq_down || (down == 1 && kbd->sysrq_alt))) {
+		kbd->sysrq_down = down;
 		return;
 	}
-	if (sysrq_down && down && !rep) {
+	if (kbd->sysrq_down && down && !kbd->rep) {
 		handle_sysrq(kbd_sysrq_xlate[keycode], vt->keyboard->dev->regs, tty);
 		return;
 	}
@@ -1053,12 +1242,13 @@ static void kbd_keycode(struct vt_struct *vt, unsigned int keycode, int down, in
 		raw_mode = 1;
 	}
 
-	if (down)
-		set_bit(keycode, key_down);
-	else
-		clear_bit(keycode, key_down);
+	if (down) {
+		if (!test_and_set_bit(keycode, kbd->key_down))
+			kbd->keys_down++;
+	} else if (test_and_clear_bit(keycode, kbd->key_down))
+		kbd->keys_down--;
 
-	if (rep && (!get_kbd_mode(&vc->kbd_table, VC_REPEAT) || (tty && 
+	if (kbd->rep && (!get_kbd_mode(&vc->kbd_table, VC_REPEAT) || (tty && 
 		(!L_ECHO(tty) && tty->driver->chars_in_buffer(tty))))) {
 		/*
 		 * Don't repeat a key if the input buffers are not empty and the
@@ -1068,19 +1258,33 @@ static void kbd_keycode(struct vt_struct *vt, unsigned int keycode, int down, in
 		return;
 	}
 
-	shift_final = (shift_state | vc->kbd_table.slockstate) ^ vc->kbd_table.lockstate;
+	shift_final = (kbd->shift_state | vc->kbd_table.slockstate) ^ vc->kbd_table.lockstate;
+
+	spin_lock_irqsave(&kbd_maps_lock, flags);
 	key_map = key_maps[shift_final];
+	if (key_map && keycode < NR_KEYS) {
+		if ((kbd_map = kbd_maps[shift_final]))
+			keysym = kbd_map[get_kbd_led(&vc->kbd_table, VC_CAPSLOCK) ?
+					 NR_KEYS + keycode : keycode];
+		else if (KTYP(keysym = key_map[keycode]) == 0xf0 + KT_LETTER) {
+			/* What kbd_compile_map() would have made of it */
+			alt = NULL;
+			if (get_kbd_led(&vc->kbd_table, VC_CAPSLOCK))
+				alt = key_maps[shift_final ^ (1 << KG_SHIFT)];
+			keysym = U(K(KT_LATIN, KVAL(alt ? alt[keycode] : keysym)));
+		}
+	}
+	spin_unlock_irqrestore(&kbd_maps_lock, flags);
 
 	if (!key_map) {
-		compute_shiftstate();
+		compute_shiftstate(vt);
 		vc->kbd_table.slockstate = 0;
 		return;
 	}
 
-	if (keycode > NR_KEYS)
+	if (keycode >= NR_KEYS)
 		return;
 
-	keysym = key_map[keycode];
 	type = KTYP(keysym);
 
 	if (type < 0xf0) {
@@ -1093,15 +1297,6 @@ static void kbd_keycode(struct vt_struct *vt, unsigned int keycode, int down, in
 	if (raw_mode && type != KT_SPEC && type != KT_SHIFT)
 		return;
 
-	if (type == KT_LETTER) {
-		type = KT_LATIN;
-		if (get_kbd_led(&vc->kbd_table, VC_CAPSLOCK)) {
-			key_map = key_maps[shift_final ^ (1 << KG_SHIFT)];
-			if (key_map)
-				keysym = key_map[keycode];
-		}
-	}
-
 	(*k_handler[type])(vc, keysym & 0xff, !down);
 
 	if (type != KT_SLOCK)
@@ -1119,7 +1314,8 @@ static void kbd_event(struct input_handle *handle, unsigned int event_type,
 		kbd_rawcode(vt->fg_console, value);
 	if (event_type == EV_KEY)
 		kbd_keycode(vt, event_code, value, HW_RAW(handle->dev));
-	tasklet_schedule(&keyboard_tasklet);
+	if (event_type == EV_SYN)
+		kbd_push(vt);
 	do_poke_blanked_console = 1;
 	schedule_work(&vt->vt_work);
 }
@@ -1168,6 +1364,8 @@ static struct input_handle *kbd_connect(struct input_handler *handler,
 	if (i != BTN_MISC) {
 		list_for_each_entry(vt, &vt_list, node) {
 			if (!vt->keyboard) {
+				memset(&vt->kbd_state, 0, sizeof(vt->kbd_state));
+				vt->kbd_state.npadch = -1;
 				vt->keyboard = handle;
 				handle->private = vt;
 				printk(KERN_INFO "keyboard.c: [%s] vc:%d-%d\n",
@@ -1227,7 +1425,14 @@ static struct input_handler kbd_handler = {
 
 int __init kbd_init(void)
 {
+	struct vt_struct *vt;
+	int i;
+
+	for (i = 0; i < MAX_NR_KEYMAPS; i++)
+		kbd_compile_map(i);
 	input_register_handler(&kbd_handler);
+	list_for_each_entry(vt, &vt_list, node)
+		kbd_leds_dirty(vt);
 	tasklet_enable(&keyboard_tasklet);
 	tasklet_schedule(&keyboard_tasklet);
 	return 0;
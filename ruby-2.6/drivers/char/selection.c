@@ -6,6 +6,8 @@
  *     'int set_selection(struct tiocl_selection __user *, struct tty_struct *)'
  *     'void clear_selection(void)'
  *     'int paste_selection(struct tty_struct *)'
+ *     'void paste_work(void *)'
+ *     'void paste_cancel(struct vc_data *)'
  *     'int sel_loadlut(char __user *)'
  *
  * Now that /dev/vcs exists, most of this can disappear again.
@@ -17,6 +19,7 @@
 #include <linux/mm.h>
 #include <linux/slab.h>
 #include <linux/types.h>
+#include <linux/workqueue.h>
 
 #include <asm/uaccess.h>
 
@@ -279,6 +282,95 @@ int set_selection(const struct tiocl_selection __user *sel, struct tty_struct *t
 	return 0;
 }
 
+/*
+ * Pasting is asynchronous: the selection is appended to a per-VC queue
+ * and fed to the line discipline from keventd as fast as it takes it.
+ * A throttled tty leaves the rest queued until vt_unthrottle() kicks
+ * the work again, so neither the pasting process nor keventd sleeps
+ * on a slow reader, and pastes made meanwhile just join the queue, up
+ * to PASTE_MAX bytes.
+ */
+#define PASTE_MAX	65536	/* bytes queued per VC */
+
+static void paste_stall_end(struct vc_data *vc)
+{
+	if (vc->vc_paste_stall) {
+		vc->vc_stats.paste_stall_ns += sched_clock() - vc->vc_paste_stall;
+		vc->vc_paste_stall = 0;
+	}
+}
+
+static void paste_drop(struct vc_data *vc)
+{
+	paste_stall_end(vc);
+	kfree(vc->vc_paste_buf);
+	vc->vc_paste_buf = NULL;
+	vc->vc_paste_len = vc->vc_paste_pos = 0;
+}
+
+void paste_work(void *private)
+{
+	struct vc_data *vc = private;
+	struct tty_struct *tty;
+	struct tty_ldisc *ld;
+	int count;
+
+	down(&vc->vc_paste_sem);
+	if (!vc->vc_paste_buf)
+		goto out;
+	if (!(tty = vc->vc_tty)) {
+		paste_drop(vc);
+		goto out;
+	}
+	ld = tty_ldisc_ref(tty);
+	if (!ld) {
+		/* the ldisc is being changed, try again shortly */
+		schedule_delayed_work(&vc->vc_paste_work, 1);
+		goto out;
+	}
+	while (vc->vc_paste_pos < vc->vc_paste_len) {
+		if (test_bit(TTY_THROTTLED, &tty->flags)) {
+			if (!vc->vc_paste_stall)
+				vc->vc_paste_stall = sched_clock();
+			break;
+		}
+		count = vc->vc_paste_len - vc->vc_paste_pos;
+		count = min(count, tty->ldisc.receive_room(tty));
+		if (!count) {
+			/*
+			 * Full but not throttled.  Throttle it ourselves, so
+			 * the read that makes room calls vt_unthrottle(); a
+			 * read that got in first has made room already.
+			 */
+			set_bit(TTY_THROTTLED, &tty->flags);
+			smp_mb();
+			if (tty->ldisc.receive_room(tty))
+				clear_bit(TTY_THROTTLED, &tty->flags);
+			continue;
+		}
+		paste_stall_end(vc);
+		tty->ldisc.receive_buf(tty, vc->vc_paste_buf + vc->vc_paste_pos,
+				       NULL, count);
+		vc->vc_paste_pos += count;
+		vc->vc_stats.paste_bytes += count;
+	}
+	if (vc->vc_paste_pos == vc->vc_paste_len)
+		paste_drop(vc);
+	tty_ldisc_deref(ld);
+out:
+	up(&vc->vc_paste_sem);
+}
+
+/* Throw away what is queued and wait out a running paste */
+void paste_cancel(struct vc_data *vc)
+{
+	down(&vc->vc_paste_sem);
+	paste_drop(vc);
+	up(&vc->vc_paste_sem);
+	cancel_delayed_work(&vc->vc_paste_work);
+	flush_scheduled_work();
+}
+
 /* Insert the contents of the selection buffer into the
  * queue of the tty associated with the current console.
  * Invoked by ioctl().
@@ -286,30 +378,39 @@ int set_selection(const struct tiocl_selection __user *sel, struct tty_struct *t
 int paste_selection(struct tty_struct *tty)
 {
 	struct	vc_data *vc = (struct vc_data *) tty->driver_data;
-	struct	tty_ldisc *ld;
-	int	pasted = 0, count;
-	DECLARE_WAITQUEUE(wait, current);
+	unsigned int left;
+	char *buf;
+	int ret = 0;
 
-	acquire_console_sem();
+	acquire_vt_sem(vc->display_fg);
 	poke_blanked_console(vc->display_fg);
-	release_console_sem();
+	release_vt_sem(vc->display_fg);
 
-	ld = tty_ldisc_ref_wait(tty);
-	
-	add_wait_queue(&vc->paste_wait, &wait);
-	while (sel_buffer && sel_buffer_lth > pasted) {
-		set_current_state(TASK_INTERRUPTIBLE);
-		if (test_bit(TTY_THROTTLED, &tty->flags)) {
-			schedule();
-			continue;
-		}
-		count = sel_buffer_lth - pasted;
-		count = min(count, tty->ldisc.receive_room(tty));
-		tty->ldisc.receive_buf(tty, sel_buffer + pasted, NULL, count);
-		pasted += count;
+	down(&vc->vc_paste_sem);
+	acquire_console_sem();
+	if (!sel_buffer || !sel_buffer_lth)
+		goto unlock;
+	left = vc->vc_paste_len - vc->vc_paste_pos;
+	/* one selection always fits; more wait for the reader */
+	if (left && left + sel_buffer_lth > PASTE_MAX) {
+		ret = -EAGAIN;
+		goto unlock;
 	}
-	remove_wait_queue(&vc->paste_wait, &wait);
-	set_current_state(TASK_RUNNING);
-	tty_ldisc_deref(ld);
-	return 0;
+	buf = kmalloc(left + sel_buffer_lth, GFP_KERNEL);
+	if (!buf) {
+		ret = -ENOMEM;
+		goto unlock;
+	}
+	if (left)
+		memcpy(buf, vc->vc_paste_buf + vc->vc_paste_pos, left);
+	memcpy(buf + left, sel_buffer, sel_buffer_lth);
+	kfree(vc->vc_paste_buf);
+	vc->vc_paste_buf = buf;
+	vc->vc_paste_pos = 0;
+	vc->vc_paste_len = left + sel_buffer_lth;
+	schedule_work(&vc->vc_paste_work);
+unlock:
+	release_console_sem();
+	up(&vc->vc_paste_sem);
+	return ret;
 }
@@ -93,6 +93,7 @@
 #include <linux/idr.h>
 #include <linux/wait.h>
 #include <linux/bitops.h>
+#include <linux/workqueue.h>
 
 #include <asm/uaccess.h>
 #include <asm/system.h>
@@ -163,8 +164,75 @@ static struct tty_struct *alloc_tty_struct(void)
 	return tty;
 }
 
+static void tty_flip_discard(struct tty_struct *tty);
+
+/*
+ * Throw away all input not yet read: the flip backlog and what the
+ * line discipline holds.  Every input flush goes through here, so no
+ * backlog survives one.  ld may be NULL.
+ */
+static void tty_flush_input(struct tty_struct *tty, struct tty_ldisc *ld)
+{
+	tty_flip_discard(tty);
+	if (ld && ld->flush_buffer)
+		ld->flush_buffer(tty);
+}
+
+/*
+ * Flip buffer pushes run on their own workqueue, so input does not wait
+ * behind whatever else keventd is busy with.  Ttys with flip.low_latency
+ * set (the input_low_latency class device attribute) get a single
+ * worker of their own running at nice -20, so a busy system does not
+ * hold their input back either.  Until the queues are created at
+ * tty_init() time pushes go to keventd.
+ */
+static struct workqueue_struct *tty_flip_wq, *tty_flip_hi_wq;
+
+static void tty_schedule_flip_work(struct tty_struct *tty, unsigned long delay)
+{
+	struct workqueue_struct *wq;
+
+	wq = tty->flip.low_latency ? tty_flip_hi_wq : tty_flip_wq;
+	if (!wq)
+		schedule_delayed_work(&tty->flip.work, delay);
+	else if (!delay)
+		queue_work(wq, &tty->flip.work);
+	else
+		queue_delayed_work(wq, &tty->flip.work, delay);
+}
+
+static void tty_flush_flip_work(void)
+{
+	if (tty_flip_wq)
+		flush_workqueue(tty_flip_wq);
+	if (tty_flip_hi_wq)
+		flush_workqueue(tty_flip_hi_wq);
+	flush_scheduled_work();
+}
+
+/* Runs once on the high priority worker; workqueues have no knob for it */
+static void __init tty_flip_hi_setup(void *unused)
+{
+	set_user_nice(current, -20);
+}
+
+/* Called with read_lock held */
+static void tty_flip_account(struct tty_struct *tty, unsigned long long now)
+{
+	unsigned long long t = (now - tty->flip.pushed) >> 10;
+	int b = 0;
+
+	while (t && b < TTY_FLIP_LATENCY_BUCKETS - 1) {
+		t >>= 1;
+		b++;
+	}
+	tty->flip.latency[b]++;
+	tty->flip.pushed = 0;
+}
+
 static inline void free_tty_struct(struct tty_struct *tty)
 {
+	tty_flip_discard(tty);
 	kfree(tty->write_buf);
 	kfree(tty);
 }
@@ -524,7 +592,7 @@ restart:
 	 * Wait for ->hangup_work and ->flip.work handlers to terminate
 	 */
 	 
-	flush_scheduled_work();
+	tty_flush_flip_work();
 	/* Shutdown the current discipline. */
 	if (tty->ldisc.close)
 		(tty->ldisc.close)(tty);
@@ -573,7 +641,7 @@ restart:
 	/* Restart it in case no characters kick it off. Safe if
 	   already running */
 	if(work)
-		schedule_delayed_work(&tty->flip.work, 1);
+		tty_schedule_flip_work(tty, 1);
 	return retval;
 }
 
@@ -727,11 +795,10 @@ EXPORT_SYMBOL_GPL(tty_wakeup);
 void tty_ldisc_flush(struct tty_struct *tty)
 {
 	struct tty_ldisc *ld = tty_ldisc_ref(tty);
-	if(ld) {
-		if(ld->flush_buffer)
-			ld->flush_buffer(tty);
+
+	tty_flush_input(tty, ld);
+	if(ld)
 		tty_ldisc_deref(ld);
-	}
 }
 
 EXPORT_SYMBOL_GPL(tty_ldisc_flush);
@@ -781,10 +848,9 @@ static void do_tty_hangup(void *data)
 	 * this question is especially important now that we've removed the irqlock. */
 
 	ld = tty_ldisc_ref(tty);
+	tty_flush_input(tty, ld);
 	if(ld != NULL)	/* We may have no line discipline at this point */
 	{
-		if (ld->flush_buffer)
-			ld->flush_buffer(tty);
 		if (tty->driver->flush_buffer)
 			tty->driver->flush_buffer(tty);
 		if ((test_bit(TTY_DO_WRITE_WAKEUP, &tty->flags)) &&
@@ -1014,6 +1080,9 @@ static ssize_t tty_read(struct file * file, char __user * buf, size_t count,
 		i = -EIO;
 	tty_ldisc_deref(ld);
 	unlock_kernel();
+	/* The read made room; let the backlog in */
+	if (tty->flip.head)
+		tty_schedule_flip_work(tty, 0);
 	if (i > 0)
 		inode->i_atime = current_fs_time(inode->i_sb);
 	return i;
@@ -1687,7 +1756,7 @@ static void release_dev(struct file * filp)
 	 * Wait for ->hangup_work and ->flip.work handlers to terminate
 	 */
 	 
-	flush_scheduled_work();
+	tty_flush_flip_work();
 	
 	/*
 	 * Wait for any short term users (we know they are just driver
@@ -2387,6 +2456,9 @@ int tty_ioctl(struct inode * inode, struct file * file,
 		if (retval == -ENOIOCTLCMD)
 			retval = -EINVAL;
 	}
+	/* The ldisc flushed its own queue; the flip backlog is ours */
+	if (cmd == TCFLSH && !retval && (arg == TCIFLUSH || arg == TCIOFLUSH))
+		tty_flip_discard(tty);
 	tty_ldisc_deref(ld);
 	return retval;
 }
@@ -2429,8 +2501,7 @@ static void __do_SAK(void *arg)
 	
 	/* We don't want an ldisc switch during this */
 	disc = tty_ldisc_ref(tty);
-	if (disc && disc->flush_buffer)
-		disc->flush_buffer(tty);
+	tty_flush_input(tty, disc);
 	tty_ldisc_deref(disc);
 
 	if (tty->driver->flush_buffer)
@@ -2485,9 +2556,133 @@ void do_SAK(struct tty_struct *tty)
 
 EXPORT_SYMBOL(do_SAK);
 
+/*
+ * Append input the line discipline could not take to the backlog
+ * chain.  Called without tty->read_lock held; may be called from the
+ * low latency path, hence GFP_ATOMIC.
+ */
+static void tty_flip_queue(struct tty_struct *tty, const unsigned char *cp,
+			   const char *fp, int count)
+{
+	struct tty_flip_chunk *c;
+	unsigned long flags;
+	int n;
+
+	spin_lock_irqsave(&tty->read_lock, flags);
+	while (count) {
+		c = tty->flip.tail;
+		if (!c || c->count == TTY_FLIPBUF_SIZE) {
+			c = NULL;
+			if (tty->flip.chunks < TTY_FLIP_MAX_CHUNKS)
+				c = kmalloc(sizeof(*c), GFP_ATOMIC);
+			if (!c) {
+				tty->flip.dropped += count;
+				break;
+			}
+			c->next = NULL;
+			c->count = c->read = 0;
+			if (tty->flip.tail)
+				tty->flip.tail->next = c;
+			else
+				tty->flip.head = c;
+			tty->flip.tail = c;
+			tty->flip.chunks++;
+		}
+		n = min(count, TTY_FLIPBUF_SIZE - c->count);
+		memcpy(c->char_buf + c->count, cp, n);
+		memcpy(c->flag_buf + c->count, fp, n);
+		c->count += n;
+		cp += n;
+		fp += n;
+		count -= n;
+	}
+	spin_unlock_irqrestore(&tty->read_lock, flags);
+}
+
+/*
+ * Hand the backlog to the line discipline for as long as it has room.
+ * The chunk being delivered is taken off the chain under read_lock, so
+ * tty_flip_discard() cannot free it meanwhile, and only one drain runs
+ * at a time.  Returns nonzero if anything is left over.
+ */
+static int tty_flip_drain(struct tty_struct *tty, struct tty_ldisc *disc)
+{
+	struct tty_flip_chunk *c;
+	unsigned long flags;
+	int n, room, left;
+
+	for (;;) {
+		room = disc->receive_room ? disc->receive_room(tty) : INT_MAX;
+
+		spin_lock_irqsave(&tty->read_lock, flags);
+		c = tty->flip.head;
+		if (!c || tty->flip.draining || room <= 0)
+			break;
+		tty->flip.head = c->next;
+		if (!c->next)
+			tty->flip.tail = NULL;
+		tty->flip.draining = c;
+		spin_unlock_irqrestore(&tty->read_lock, flags);
+
+		n = min(c->count - c->read, room);
+		disc->receive_buf(tty, c->char_buf + c->read,
+				  c->flag_buf + c->read, n);
+
+		spin_lock_irqsave(&tty->read_lock, flags);
+		tty->flip.draining = NULL;
+		c->read += n;
+		if (c->read < c->count) {
+			/* Back to the front, ahead of anything queued since */
+			c->next = tty->flip.head;
+			tty->flip.head = c;
+			if (!c->next)
+				tty->flip.tail = c;
+			c = NULL;
+		} else
+			tty->flip.chunks--;
+		spin_unlock_irqrestore(&tty->read_lock, flags);
+		kfree(c);
+	}
+	left = c != NULL;
+	spin_unlock_irqrestore(&tty->read_lock, flags);
+	return left;
+}
+
+/*
+ * Throw the backlog away, on input flush and when the tty goes away.
+ * A chunk tty_flip_drain() is delivering is only marked empty; the
+ * drain frees it.
+ */
+static void tty_flip_discard(struct tty_struct *tty)
+{
+	struct tty_flip_chunk *c, *next;
+	unsigned long flags;
+
+	spin_lock_irqsave(&tty->read_lock, flags);
+	c = tty->flip.head;
+	tty->flip.head = tty->flip.tail = NULL;
+	tty->flip.chunks = 0;
+	if (tty->flip.draining) {
+		tty->flip.draining->count = 0;
+		tty->flip.chunks = 1;
+	}
+	spin_unlock_irqrestore(&tty->read_lock, flags);
+
+	for (; c; c = next) {
+		next = c->next;
+		kfree(c);
+	}
+}
+
 /*
  * This routine is called out of the software interrupt to flush data
  * from the flip buffer to the line discipline. 
+ *
+ * The filled half is always flipped out so that the driver gets a fresh
+ * one.  What the line discipline cannot take now, because TTY_DONT_FLIP
+ * is set or it has no room, goes to the backlog chain.  A read makes
+ * room and clears TTY_DONT_FLIP, so tty_read() queues us again; the
+ * chain is not polled while the line discipline is full.
  */
  
 static void flush_to_ldisc(void *private_)
@@ -2495,22 +2690,18 @@ static void flush_to_ldisc(void *private_)
 	struct tty_struct *tty = (struct tty_struct *) private_;
 	unsigned char	*cp;
 	char		*fp;
-	int		count;
+	int		count, n;
 	unsigned long 	flags;
 	struct tty_ldisc *disc;
+	char		buf[64];
 
 	disc = tty_ldisc_ref(tty);
 	if (disc == NULL)	/*  !TTY_LDISC */
 		return;
 
-	if (test_bit(TTY_DONT_FLIP, &tty->flags)) {
-		/*
-		 * Do it after the next timer tick:
-		 */
-		schedule_delayed_work(&tty->flip.work, 1);
-		goto out;
-	}
 	spin_lock_irqsave(&tty->read_lock, flags);
+	if (tty->flip.pushed)
+		tty_flip_account(tty, sched_clock());
 	if (tty->flip.buf_num) {
 		cp = tty->flip.char_buf + TTY_FLIPBUF_SIZE;
 		fp = tty->flip.flag_buf + TTY_FLIPBUF_SIZE;
@@ -2528,8 +2719,39 @@ static void flush_to_ldisc(void *private_)
 	tty->flip.count = 0;
 	spin_unlock_irqrestore(&tty->read_lock, flags);
 
-	disc->receive_buf(tty, cp, fp, count);
-out:
+	if (!test_bit(TTY_DONT_FLIP, &tty->flags) && !tty_flip_drain(tty, disc)) {
+		/* Backlog is empty, the fresh input can go straight in */
+		n = count;
+		if (disc->receive_room)
+			n = min(n, disc->receive_room(tty));
+		if (n > 0) {
+			disc->receive_buf(tty, cp, fp, n);
+			cp += n;
+			fp += n;
+			count -= n;
+		}
+	}
+	if (count) {
+		tty_flip_queue(tty, cp, fp, count);
+		if (test_bit(TTY_DONT_FLIP, &tty->flags)) {
+			/*
+			 * Do it after the next timer tick, in case the
+			 * reader was done before this got queued:
+			 */
+			tty_schedule_flip_work(tty, 1);
+		} else {
+			/* A drain that ended before it was queued missed it */
+			tty_flip_drain(tty, disc);
+		}
+	}
+
+	if (tty->flip.dropped != tty->flip.dropped_reported) {
+		if (printk_ratelimit())
+			printk(KERN_WARNING "%s: %lu input bytes dropped\n",
+			       tty_name(tty, buf),
+			       tty->flip.dropped - tty->flip.dropped_reported);
+		tty->flip.dropped_reported = tty->flip.dropped;
+	}
 	tty_ldisc_deref(disc);
 }
 
@@ -2614,16 +2836,26 @@ EXPORT_SYMBOL(tty_get_baud_rate);
  *	Queue a push of the terminal flip buffers to the line discipline. This
  *	function must not be called from IRQ context if tty->low_latency is set.
  *
- *	In the event of the queue being busy for flipping the work will be
- *	held off and retried later.
+ *	Otherwise the push is queued to run right away on the tty flip
+ *	workqueue, rather than after the next timer tick.  In the event of
+ *	the queue being busy for flipping the work will be held off and
+ *	retried later.  The time from the first push to the flush that takes
+ *	the bytes goes into the tty's latency histogram.
  */
 
 void tty_flip_buffer_push(struct tty_struct *tty)
 {
+	unsigned long flags;
+
+	spin_lock_irqsave(&tty->read_lock, flags);
+	if (!tty->flip.pushed)
+		tty->flip.pushed = sched_clock();
+	spin_unlock_irqrestore(&tty->read_lock, flags);
+
 	if (tty->low_latency)
 		flush_to_ldisc((void *) tty);
 	else
-		schedule_delayed_work(&tty->flip.work, 1);
+		tty_schedule_flip_work(tty, 0);
 }
 
 EXPORT_SYMBOL(tty_flip_buffer_push);
@@ -2663,6 +2895,88 @@ static void tty_default_put_char(struct tty_struct *tty, unsigned char ch)
 
 static struct class_simple *tty_class;
 
+/*
+ * Attributes of the per line class devices.  They act on the tty open on
+ * the line and fail with -ENODEV while there is none; the class data is
+ * the line's slot in driver->ttys.  tty_sem and the BKL keep init_dev()
+ * and release_dev() from changing the slot meanwhile.
+ *	input_low_latency	0 or 1, see tty_schedule_flip_work()
+ *	input_latency		one line per histogram bucket: lower bound
+ *				in microseconds, pushes flushed
+ */
+static struct tty_struct *tty_lock_line(struct class_device *cdev)
+{
+	struct tty_struct **slot = class_get_devdata(cdev);
+
+	down(&tty_sem);
+	lock_kernel();
+	if (*slot)
+		return *slot;
+	unlock_kernel();
+	up(&tty_sem);
+	return NULL;
+}
+
+static void tty_unlock_line(void)
+{
+	unlock_kernel();
+	up(&tty_sem);
+}
+
+static ssize_t tty_show_input_low_latency(struct class_device *cdev,
+					  char *buf)
+{
+	struct tty_struct *tty = tty_lock_line(cdev);
+	int n;
+
+	if (!tty)
+		return -ENODEV;
+	n = sprintf(buf, "%d\n", tty->flip.low_latency);
+	tty_unlock_line();
+	return n;
+}
+
+static ssize_t tty_store_input_low_latency(struct class_device *cdev,
+					   const char *buf, size_t count)
+{
+	struct tty_struct *tty;
+	char *end;
+	unsigned long on = simple_strtoul(buf, &end, 0);
+
+	if (end == buf || on > 1)
+		return -EINVAL;
+	tty = tty_lock_line(cdev);
+	if (!tty)
+		return -ENODEV;
+	tty->flip.low_latency = on;
+	tty_unlock_line();
+	return count;
+}
+static CLASS_DEVICE_ATTR(input_low_latency, S_IRUGO | S_IWUSR,
+			 tty_show_input_low_latency,
+			 tty_store_input_low_latency);
+
+static ssize_t tty_show_input_latency(struct class_device *cdev, char *buf)
+{
+	struct tty_struct *tty = tty_lock_line(cdev);
+	unsigned long latency[TTY_FLIP_LATENCY_BUCKETS];
+	unsigned long flags;
+	int i, n = 0;
+
+	if (!tty)
+		return -ENODEV;
+	spin_lock_irqsave(&tty->read_lock, flags);
+	memcpy(latency, tty->flip.latency, sizeof(latency));
+	spin_unlock_irqrestore(&tty->read_lock, flags);
+	tty_unlock_line();
+
+	for (i = 0; i < TTY_FLIP_LATENCY_BUCKETS; i++)
+		n += sprintf(buf + n, "%lu %lu\n", i ? 1UL << (i - 1) : 0,
+			     latency[i]);
+	return n;
+}
+static CLASS_DEVICE_ATTR(input_latency, S_IRUGO, tty_show_input_latency, NULL);
+
 /**
  * tty_register_device - register a tty device
  * @driver: the tty driver that describes the tty device
@@ -2680,6 +2994,7 @@ void tty_register_device(struct tty_driver *driver, unsigned index,
 {
 	char name[64];
 	dev_t dev = MKDEV(driver->major, driver->minor_start) + index;
+	struct class_device *cdev;
 
 	if (index >= driver->num) {
 		printk(KERN_ERR "Attempt to register invalid tty line number "
@@ -2694,7 +3009,12 @@ void tty_register_device(struct tty_driver *driver, unsigned index,
 		pty_line_name(driver, index, name);
 	else
 		tty_line_name(driver, index, name);
-	class_simple_device_add(tty_class, dev, device, name);
+	cdev = class_simple_device_add(tty_class, dev, device, name);
+	if (IS_ERR(cdev) || !driver->ttys)
+		return;
+	class_set_devdata(cdev, &driver->ttys[index]);
+	class_device_create_file(cdev, &class_device_attr_input_low_latency);
+	class_device_create_file(cdev, &class_device_attr_input_latency);
 }
 
 /**
@@ -2949,6 +3269,16 @@ static struct cdev vc0_cdev;
  */
 static int __init tty_init(void)
 {
+	tty_flip_wq = create_workqueue("ttyflip");
+	tty_flip_hi_wq = create_singlethread_workqueue("ttyfliphi");
+	if (tty_flip_hi_wq) {
+		static struct work_struct setup __initdata;
+
+		INIT_WORK(&setup, tty_flip_hi_setup, NULL);
+		queue_work(tty_flip_hi_wq, &setup);
+		flush_workqueue(tty_flip_hi_wq);
+	}
+
 	cdev_init(&tty_cdev, &tty_fops);
 	if (cdev_add(&tty_cdev, MKDEV(TTYAUX_MAJOR, 0), 1) ||
 	    register_chrdev_region(MKDEV(TTYAUX_MAJOR, 0), 1, "/dev/tty") < 0)
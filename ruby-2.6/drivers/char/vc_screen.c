@@ -14,6 +14,9 @@
  * This replaces screendump and part of selection, so that the system
  * administrator can control access using file system permissions.
  *
+ * poll() reports POLLPRI once the screen or the cursor has changed since
+ * the file was last read, so monitors need not re-read idle consoles.
+ *
  * aeb@cwi.nl - efter Friedas begravelse - 950211
  *
  * machek@k332.feld.cvut.cz - modified not to send characters to wrong console
@@ -30,6 +33,8 @@
 #include <linux/sched.h>
 #include <linux/interrupt.h>
 #include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/poll.h>
 #include <linux/init.h>
 #include <linux/vt_kern.h>
 #include <linux/selection.h>
@@ -42,6 +47,38 @@
 
 #define HEADER_SIZE	4
 
+struct vcs_file {
+	unsigned int seen;		/* vc_generation at the last read */
+};
+
+/*
+ * Pollers sleep here rather than in the vc_data, which vc_disallocate()
+ * frees under them.  Set up by vcs_init().
+ */
+static wait_queue_head_t vcs_wait[MAX_NR_CONSOLES];
+static int vcs_wait_ready;
+
+/*
+ * Take the display lock of the VC a vcs file shows and return the VC,
+ * or NULL with nothing held if it is not allocated.  The VC is looked
+ * up afresh every time, and VT_DISALLOCATE frees it only under that
+ * lock.
+ */
+static struct vc_data *vcs_lock(struct inode *inode)
+{
+	unsigned int currcons = iminor(inode) & 127;
+	struct vt_struct *vt = find_vt(currcons);
+	struct vc_data *vc;
+
+	if (!vt)
+		return NULL;
+	down(&vt->lock);
+	vc = vt->vc_cons[currcons - vt->first_vc];
+	if (!vc)
+		up(&vt->lock);
+	return vc;
+}
+
 unsigned short *screen_pos(struct vc_data *vc, int w_offset, int viewed)
 {
 	return screenpos(vc, 2 * w_offset, viewed);
@@ -75,6 +112,34 @@ void vcs_scr_writew(struct vc_data *vc, u16 val, u16 *org)
 	}
 }
 
+/*
+ * Called after each batch of changes to the contents or the cursor of
+ * a console, so that readers can tell a screen has not moved since
+ * they last looked.
+ */
+void vcs_scr_updated(struct vc_data *vc)
+{
+	vc->vc_generation++;
+	if (vcs_wait_ready)
+		wake_up_interruptible(&vcs_wait[vc->vc_num]);
+}
+
+/*
+ * Index of the cell under the software cursor if it lies within the
+ * count cells at org, else -1.  The bulk copies below read the buffer
+ * directly and patch that one cell the way vcs_scr_readw() would.
+ */
+static inline long
+vcs_cursor_cell(struct vc_data *vc, const u16 *org, long count)
+{
+	const u16 *pos = (const u16 *)vc->vc_pos;
+
+	if (vc->display_fg->cursor_original == -1 ||
+	    pos < org || pos >= org + count)
+		return -1;
+	return pos - org;
+}
+
 static int
 vcs_size(struct vc_data *vc, unsigned long attr)
 {
@@ -88,11 +153,12 @@ vcs_size(struct vc_data *vc, unsigned long attr)
 static loff_t vcs_lseek(struct file *file, loff_t offset, int orig)
 {
 	struct inode *inode = file->f_dentry->d_inode;
-	struct vc_data *vc = file->private_data;
+	struct vc_data *vc = vcs_lock(inode);
 	long attr = iminor(inode) & 128;
 	int size;
 
-	down(&vc->display_fg->lock);
+	if (!vc)
+		return -ENXIO;
 	size = vcs_size(vc, attr);
 	switch (orig) {
 		default:
@@ -119,7 +185,8 @@ static ssize_t
 vcs_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
 {
 	struct inode *inode = file->f_dentry->d_inode;
-	struct vc_data *vc = file->private_data;
+	struct vcs_file *vf = file->private_data;
+	struct vc_data *vc = vcs_lock(inode);
 	long attr = iminor(inode) & 128;
 	unsigned short *org = NULL;
 	long viewed, read, pos;
@@ -128,7 +195,6 @@ vcs_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
 
 	if (!vc)
 		return ret;
-	down(&vc->display_fg->lock);
 	
 	pos = *ppos;
 	/* 
@@ -136,6 +202,8 @@ vcs_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
 	 * sanity of the situation under the console lock.
 	 */
 	acquire_console_sem();
+	vc_sb_reset(vc);
+	vf->seen = vc->vc_generation;
 
 	if (IS_VISIBLE) {
 		viewed = 1;
@@ -176,7 +244,16 @@ vcs_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
 		con_buf_start = con_buf0 = vc->display_fg->con_buf;
 		orig_count = this_round;
 		maxcol = vc->vc_cols;
-		if (!attr) {
+		if (!attr && !viewed) {
+			/* Off screen the buffer is linear, no row wrapping */
+			long i;
+
+			org = screen_pos(vc, p, 0);
+			for (i = 0; i < this_round; i++)
+				con_buf0[i] = scr_readw(org + i) & 0xff;
+			if ((i = vcs_cursor_cell(vc, org, this_round)) >= 0)
+				con_buf0[i] = vc->display_fg->cursor_original & 0xff;
+		} else if (!attr) {
 			org = screen_pos(vc, p, viewed);
 			col = p % maxcol;
 			p += maxcol - col;
@@ -239,6 +316,14 @@ vcs_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
 				 */
 				this_round = (this_round + 1) >> 1;
 
+				if (!viewed) {
+					long i;
+
+					scr_memcpyw(tmp_buf, org, this_round * 2);
+					if ((i = vcs_cursor_cell(vc, org, this_round)) >= 0)
+						tmp_buf[i] = vc->display_fg->cursor_original;
+					this_round = 0;
+				}
 				while (this_round) {
 					*tmp_buf++ = vcs_scr_readw(vc, org++);
 					this_round --;
@@ -285,7 +370,7 @@ static ssize_t
 vcs_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
 {
 	struct inode *inode = file->f_dentry->d_inode;
-	struct vc_data *vc = file->private_data;
+	struct vc_data *vc = vcs_lock(inode);
 	long viewed, size, written, pos;
 	long attr = iminor(inode) & 128;
 	u16 *org0 = NULL, *org = NULL;
@@ -295,13 +380,13 @@ vcs_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
 
 	if (!vc)
 		return ret;
-	down(&vc->display_fg->lock);
 
 	/* 
 	 * Select the proper current console and verify
 	 * sanity of the situation under the console lock.
 	 */
 	acquire_console_sem();
+	vc_sb_reset(vc);
 
 	pos = *ppos;
 	if (IS_VISIBLE) {
@@ -331,6 +416,7 @@ vcs_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
 		release_console_sem();
 		ret = copy_from_user(vc->display_fg->con_buf, buf, this_round);
 		acquire_console_sem();
+		vc_sb_reset(vc);
 
 		if (ret) {
 			this_round -= ret;
@@ -453,6 +539,8 @@ vcs_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
 	}
 	*ppos += written;
 	ret = written;
+	if (written)
+		vcs_scr_updated(vc);
 
 unlock_out:
 	release_console_sem();
@@ -460,15 +548,44 @@ unlock_out:
 	return ret;
 }
 
+static unsigned int
+vcs_poll(struct file *file, poll_table *wait)
+{
+	struct vcs_file *vf = file->private_data;
+	struct vc_data *vc = vcs_lock(file->f_dentry->d_inode);
+	unsigned int mask = POLLIN | POLLRDNORM | POLLOUT | POLLWRNORM;
+
+	if (!vc)
+		return POLLERR | POLLHUP;
+	poll_wait(file, &vcs_wait[vc->vc_num], wait);
+	if (vf->seen != vc->vc_generation)
+		mask |= POLLPRI;
+	up(&vc->display_fg->lock);
+	return mask;
+}
+
 static int
 vcs_open(struct inode *inode, struct file *filp)
 {
-	unsigned int currcons = iminor(inode) & 127;
-	struct vc_data *vc = find_vc(currcons);
+	struct vcs_file *vf = kmalloc(sizeof(*vf), GFP_KERNEL);
+	struct vc_data *vc;
 
-	if (!vc)
+	if (!vf)
+		return -ENOMEM;
+	if (!(vc = vcs_lock(inode))) {
+		kfree(vf);
 		return -ENXIO;
-	filp->private_data = vc;
+	}
+	vf->seen = vc->vc_generation - 1;	/* nothing read yet */
+	up(&vc->display_fg->lock);
+	filp->private_data = vf;
+	return 0;
+}
+
+static int
+vcs_release(struct inode *inode, struct file *filp)
+{
+	kfree(filp->private_data);
 	return 0;
 }
 
@@ -476,7 +593,9 @@ static struct file_operations vcs_fops = {
 	.llseek		= vcs_lseek,
 	.read		= vcs_read,
 	.write		= vcs_write,
+	.poll		= vcs_poll,
 	.open		= vcs_open,
+	.release	= vcs_release,
 };
 
 static struct class_simple *vc_class;
@@ -502,6 +621,11 @@ void vcs_remove_devfs(struct tty_struct *tty)
 
 int __init vcs_init(void)
 {
+	int i;
+
+	for (i = 0; i < MAX_NR_CONSOLES; i++)
+		init_waitqueue_head(&vcs_wait[i]);
+	vcs_wait_ready = 1;
 	if (register_chrdev(VCS_MAJOR, "vcs", &vcs_fops))
 		panic("unable to get major %d for vcs device", VCS_MAJOR);
 	vc_class = class_simple_create(THIS_MODULE, "vc");
@@ -97,6 +97,7 @@
 #include <linux/config.h>
 #include <linux/workqueue.h>
 #include <linux/bootmem.h>
+#include <linux/vmalloc.h>
 #include <linux/pm.h>
 #include <linux/font.h>
 
@@ -189,6 +190,8 @@ int (*console_blank_hook)(int);
 
 #define sw vc->display_fg->vt_sw
 
+#define VC_DAMAGE_SIZE(rows) ((rows) * 2 * sizeof(unsigned short))
+
 /*
  * Console cursor handling
  */
@@ -231,7 +234,8 @@ void hide_cursor(struct vc_data *vc)
 
 void set_cursor(struct vc_data *vc)
 {
-    if (!IS_VISIBLE || vc->display_fg->vt_blanked || vc->vc_mode == KD_GRAPHICS)
+    if (!IS_VISIBLE || vc->display_fg->vt_blanked || vc->vc_mode == KD_GRAPHICS ||
+	vc->vc_sb_offset)
 	return;
     if (vc->vc_dectcem) {
 	if (vc == sel_cons)
@@ -287,7 +291,7 @@ inline void gotoxay(struct vc_data *vc, int new_x, int new_y)
  */
 void set_palette(struct vc_data *vc)
 {
-	WARN_CONSOLE_UNLOCKED();
+	WARN_VT_UNLOCKED(vc->display_fg);
 	if (IS_VISIBLE && sw->con_set_palette && vc->vc_mode != KD_GRAPHICS)
 		sw->con_set_palette(vc, color_table);
 }
@@ -327,6 +331,138 @@ void scroll_down(struct vc_data *vc, int lines)
 	scrolldelta(vc->display_fg, lines);
 }
 
+/*
+ * Software scrollback.  Lines scrolled off the top of the whole screen
+ * are kept in a ring of vt_scrollback lines per VC, whatever the
+ * backend, so history survives console switches.  Paging back saves
+ * the live screen behind the ring and paints history over the screen
+ * buffer, which then goes out through the damage path like any other
+ * change; anything that touches the screen snaps back first.
+ */
+static unsigned int vt_scrollback = 256;
+#define VT_SCROLLBACK_MAX	32768	/* lines */
+
+static int __init vt_scrollback_setup(char *str)
+{
+	vt_scrollback = min_t(unsigned long, simple_strtoul(str, NULL, 0),
+			      VT_SCROLLBACK_MAX);
+	return 1;
+}
+
+__setup("vt_scrollback=", vt_scrollback_setup);
+
+static void vc_sb_free(struct vc_data *vc)
+{
+	if (vc->vc_sb_buf)
+		vfree(vc->vc_sb_buf);
+	vc->vc_sb_buf = NULL;
+	vc->vc_sb_size = vc->vc_sb_head = vc->vc_sb_count = 0;
+	vc->vc_sb_offset = 0;
+}
+
+/* Needs process context; history does not survive a change of geometry */
+static void vc_sb_alloc(struct vc_data *vc)
+{
+	unsigned long lines = vt_scrollback + vc->vc_rows;
+
+	vc_sb_free(vc);
+	/* A huge geometry could still overflow the size; do without */
+	if (!vt_scrollback || lines > ULONG_MAX / vc->vc_size_row)
+		return;
+	vc->vc_sb_buf = vmalloc(lines * vc->vc_size_row);
+	if (vc->vc_sb_buf)
+		vc->vc_sb_size = vt_scrollback;
+}
+
+/* The k-th most recent line of history, k >= 1 */
+static inline u16 *vc_sb_line(struct vc_data *vc, unsigned int k)
+{
+	return vc->vc_sb_buf + vc->vc_cols *
+		((vc->vc_sb_head + vc->vc_sb_size - k) % vc->vc_sb_size);
+}
+
+/* Keep the top nr rows of the screen before they scroll away */
+static void vc_sb_push(struct vc_data *vc, unsigned int nr)
+{
+	const u16 *s = (u16 *) vc->vc_origin;
+
+	for (; nr; nr--, s += vc->vc_cols) {
+		scr_memcpyw(vc->vc_sb_buf + vc->vc_sb_head * vc->vc_cols,
+			    (u16 *) s, vc->vc_size_row);
+		if (++vc->vc_sb_head == vc->vc_sb_size)
+			vc->vc_sb_head = 0;
+		if (vc->vc_sb_count < vc->vc_sb_size)
+			vc->vc_sb_count++;
+	}
+}
+
+static void vc_sb_paint(struct vc_data *vc, unsigned int offset)
+{
+	u16 *live = vc->vc_sb_buf + vc->vc_sb_size * vc->vc_cols;
+	unsigned int y;
+
+	if (!vc->vc_sb_offset) {
+		hide_cursor(vc);
+		scr_memcpyw(live, (u16 *) vc->vc_origin, vc->vc_screenbuf_size);
+	}
+	vc->vc_sb_offset = offset;
+	for (y = 0; y < vc->vc_rows; y++) {
+		u16 *src = y < offset ? vc_sb_line(vc, offset - y) :
+					live + (y - offset) * vc->vc_cols;
+
+		scr_memcpyw((u16 *) (vc->vc_origin + y * vc->vc_size_row),
+			    src, vc->vc_size_row);
+	}
+	vc_damage_lines(vc, 0, vc->vc_rows);
+	vc_flush_damage(vc);
+	if (!offset)
+		set_cursor(vc);
+}
+
+/* Back to the live screen, if scrolled back */
+void vc_sb_reset(struct vc_data *vc)
+{
+	if (vc->vc_sb_offset)
+		vc_sb_paint(vc, 0);
+}
+
+/* Page through the history; lines < 0 goes back */
+static void vc_sb_scroll(struct vc_data *vc, int lines)
+{
+	int offset = vc->vc_sb_offset - lines;
+
+	if (offset < 0)
+		offset = 0;
+	if (offset > (int) vc->vc_sb_count)
+		offset = vc->vc_sb_count;
+	if (offset != (int) vc->vc_sb_offset)
+		vc_sb_paint(vc, offset);
+}
+
+/*
+ * Pending damage travels with the text it belongs to.
+ */
+static void scroll_damage(struct vc_data *vc, unsigned int t, unsigned int b, int dir, unsigned int nr)
+{
+	unsigned short *d = vc->vc_damage_map;
+	unsigned int rows = b - t - nr;
+
+	if (vc->vc_damage_top >= b || vc->vc_damage_bottom <= t ||
+	    b > vc->vc_damage_rows)
+		return;
+	if (dir == SM_UP) {
+		memmove(d + 2 * t, d + 2 * (t + nr), rows * 2 * sizeof(*d));
+		memset(d + 2 * (b - nr), 0, nr * 2 * sizeof(*d));
+	} else {
+		memmove(d + 2 * (t + nr), d + 2 * t, rows * 2 * sizeof(*d));
+		memset(d + 2 * t, 0, nr * 2 * sizeof(*d));
+	}
+	if (vc->vc_damage_top > t)
+		vc->vc_damage_top = t;
+	if (vc->vc_damage_bottom < b)
+		vc->vc_damage_bottom = b;
+}
+
 void scroll_region_up(struct vc_data *vc, unsigned int t, unsigned int b, int nr)
 {
 	unsigned short *d, *s;
@@ -335,12 +471,19 @@ void scroll_region_up(struct vc_data *vc, unsigned int t, unsigned int b, int nr
 		nr = b - t - 1;
 	if (b > vc->vc_rows || t >= b || nr < 1)
 		return;
-	if (IS_VISIBLE && sw->con_scroll_region(vc, t, b, SM_UP, nr))
+	vc->vc_stats.scrolls += nr;
+	if (!t && b == vc->vc_rows && vc->vc_sb_buf)
+		vc_sb_push(vc, nr);
+	scroll_damage(vc, t, b, SM_UP, nr);
+	if (IS_VISIBLE && sw->con_scroll_region &&
+	    sw->con_scroll_region(vc, t, b, SM_UP, nr))
 		return;
 	d = (unsigned short *) (vc->vc_origin + vc->vc_size_row*t);
 	s = (unsigned short *) (vc->vc_origin + vc->vc_size_row*(t+nr));
 	scr_memmovew(d, s, (b-t-nr) * vc->vc_size_row);
 	scr_memsetw(d + (b-t-nr) * vc->vc_cols, vc->vc_video_erase_char, vc->vc_size_row*nr);
+	if (!sw->con_scroll_region)
+		vc_damage_lines(vc, t, b);
 }
 
 void scroll_region_down(struct vc_data *vc, unsigned int t, unsigned int b, int nr)
@@ -352,12 +495,17 @@ void scroll_region_down(struct vc_data *vc, unsigned int t, unsigned int b, int
 		nr = b - t - 1;
 	if (b > vc->vc_rows || t >= b || nr < 1)
 		return;
-	if (IS_VISIBLE && sw->con_scroll_region(vc, t, b, SM_DOWN, nr))
+	vc->vc_stats.scrolls += nr;
+	scroll_damage(vc, t, b, SM_DOWN, nr);
+	if (IS_VISIBLE && sw->con_scroll_region &&
+	    sw->con_scroll_region(vc, t, b, SM_DOWN, nr))
 		return;
 	s = (unsigned short *) (vc->vc_origin + vc->vc_size_row*t);
 	step = vc->vc_cols * nr;
 	scr_memmovew(s + step, s, (b-t-nr)*vc->vc_size_row);
 	scr_memsetw(s, vc->vc_video_erase_char, 2*step);
+	if (!sw->con_scroll_region)
+		vc_damage_lines(vc, t, b);
 }
 
 /*
@@ -435,48 +583,53 @@ static void clear_buffer_attributes(struct vc_data *vc)
 /*
  *  Character management
  */
+/*
+ * Move the cells [from, from + width) of row y to column to.  Damage
+ * still pending in the block travels with it, the backend moves what
+ * is already on the display, and a backend without con_bmove gets the
+ * destination repainted instead.
+ */
+static void move_cells(struct vc_data *vc, unsigned int y, unsigned int from,
+		       unsigned int to, unsigned int width)
+{
+	if (!DO_UPDATE || !width)
+		return;
+	if (y < vc->vc_damage_rows) {
+		unsigned short *span = vc->vc_damage_map + 2 * y;
+		unsigned int lo = max_t(unsigned int, span[0], from);
+		unsigned int hi = min_t(unsigned int, span[1], from + width);
+
+		if (lo < hi)
+			vc_damage(vc, y, lo - from + to, hi - lo);
+	}
+	if (sw->con_bmove)
+		sw->con_bmove(vc, y, from, y, to, 1, width);
+	else
+		vc_damage(vc, y, to, width);
+}
+
 void insert_char(struct vc_data *vc, unsigned int nr)
 {
-	unsigned short *p, *q = (unsigned short *) vc->vc_pos;
+	unsigned short *p = (unsigned short *) vc->vc_pos;
+	unsigned int tail = vc->vc_cols - vc->vc_x - nr;
 
-	p = q + vc->vc_cols - nr - vc->vc_x;
-	while (--p >= q)
-		scr_writew(scr_readw(p), p + nr);
-	scr_memsetw(q, vc->vc_video_erase_char, nr*2);
+	scr_memmovew(p + nr, p, tail * 2);
+	scr_memsetw(p, vc->vc_video_erase_char, nr * 2);
 	vc->vc_need_wrap = 0;
-	if (DO_UPDATE) {
-		unsigned short oldattr = vc->vc_attr;
-		sw->con_bmove(vc, vc->vc_y, vc->vc_x, vc->vc_y, vc->vc_x + nr,
-				1, vc->vc_cols - vc->vc_x - nr);
-		vc->vc_attr = vc->vc_video_erase_char >> 8;
-		while (nr--)
-			sw->con_putc(vc, vc->vc_video_erase_char, vc->vc_y,
-					vc->vc_x + nr);
-		vc->vc_attr = oldattr;
-	}
+	move_cells(vc, vc->vc_y, vc->vc_x, vc->vc_x + nr, tail);
+	vc_damage(vc, vc->vc_y, vc->vc_x, nr);
 }
 
 void delete_char(struct vc_data *vc, unsigned int nr)
 {
 	unsigned short *p = (unsigned short *) vc->vc_pos;
-	unsigned int i = vc->vc_x;
+	unsigned int tail = vc->vc_cols - vc->vc_x - nr;
 
-	while (++i <= vc->vc_cols - nr) {
-		scr_writew(scr_readw(p+nr), p);
-		p++;
-	}
-	scr_memsetw(p, vc->vc_video_erase_char, nr*2);
+	scr_memmovew(p, p + nr, tail * 2);
+	scr_memsetw(p + tail, vc->vc_video_erase_char, nr * 2);
 	vc->vc_need_wrap = 0;
-	if (DO_UPDATE) {
-		unsigned short oldattr = vc->vc_attr;
-		sw->con_bmove(vc, vc->vc_y, vc->vc_x + nr, vc->vc_y, vc->vc_x,
-				1, vc->vc_cols - vc->vc_x - nr);
-		vc->vc_attr = vc->vc_video_erase_char >> 8;
-		while (nr--)
-			sw->con_putc(vc, vc->vc_video_erase_char, vc->vc_y,
-				     vc->vc_cols - 1 - nr);
-		vc->vc_attr = oldattr;
-	}
+	move_cells(vc, vc->vc_y, vc->vc_x + nr, vc->vc_x, tail);
+	vc_damage(vc, vc->vc_y, vc->vc_cols - nr, nr);
 }
 
 void insert_line(struct vc_data *vc, unsigned int nr)
@@ -497,7 +650,7 @@ void delete_line(struct vc_data *vc, unsigned int nr)
  */
 void set_origin(struct vc_data *vc)
 {
-	WARN_CONSOLE_UNLOCKED();
+	WARN_VT_UNLOCKED(vc->display_fg);
 
 	if (!IS_VISIBLE || !sw->con_set_origin || !sw->con_set_origin(vc))
 		vc->vc_origin = (unsigned long) vc->vc_screenbuf;
@@ -506,21 +659,109 @@ void set_origin(struct vc_data *vc)
 	vc->vc_pos = vc->vc_origin + vc->vc_size_row * vc->vc_y + 2 * vc->vc_x;
 }
 
-inline void clear_region(struct vc_data *vc, int sx, int sy, int width, int height)
+/*
+ * Damage tracking.  Output to a visible console only goes to the screen
+ * buffer at first; the cells that still have to reach the display are
+ * kept as one column span per row and drawn in a single pass by
+ * vc_flush_damage(), normally once per write.
+ */
+static void vc_reset_damage(struct vc_data *vc)
+{
+	if (vc->vc_damage_map)
+		memset(vc->vc_damage_map, 0, vc->vc_damage_rows * 2 * sizeof(unsigned short));
+	vc->vc_damage_top = vc->vc_damage_rows;
+	vc->vc_damage_bottom = 0;
+}
+
+void vc_damage(struct vc_data *vc, unsigned int y, unsigned int x, unsigned int width)
+{
+	unsigned short *span;
+
+	if (!DO_UPDATE || !width)
+		return;
+	if (y >= vc->vc_damage_rows) {
+		/* no damage map to record it in */
+		do_update_region(vc, vc->vc_origin + y * vc->vc_size_row + 2 * x, width);
+		return;
+	}
+	span = vc->vc_damage_map + 2 * y;
+	if (span[0] >= span[1]) {
+		span[0] = x;
+		span[1] = x + width;
+	} else {
+		if (x < span[0])
+			span[0] = x;
+		if (x + width > span[1])
+			span[1] = x + width;
+	}
+	if (y < vc->vc_damage_top)
+		vc->vc_damage_top = y;
+	if (y >= vc->vc_damage_bottom)
+		vc->vc_damage_bottom = y + 1;
+}
+
+void vc_damage_lines(struct vc_data *vc, unsigned int top, unsigned int bottom)
+{
+	for (; top < bottom; top++)
+		vc_damage(vc, top, 0, vc->vc_cols);
+}
+
+void vc_flush_damage(struct vc_data *vc)
 {
-	/* Clears the video memory, not the screen buffer */
-	if (DO_UPDATE && sw->con_clear)
-		return sw->con_clear(vc, sy, sx, height, width);
+	unsigned int y;
+
+	for (y = vc->vc_damage_top; y < vc->vc_damage_bottom; y++) {
+		unsigned short *span = vc->vc_damage_map + 2 * y;
+
+		if (span[0] < span[1] && DO_UPDATE)
+			do_update_region(vc, vc->vc_origin + y * vc->vc_size_row + 2 * span[0],
+					 span[1] - span[0]);
+		span[0] = span[1] = 0;
+	}
+	vc->vc_damage_top = vc->vc_damage_rows;
+	vc->vc_damage_bottom = 0;
 }
 
 inline void save_screen(struct vc_data *vc)
 {
-	WARN_CONSOLE_UNLOCKED();
+	WARN_VT_UNLOCKED(vc->display_fg);
 
+	vc_sb_reset(vc);
 	if (sw->con_save_screen)
 		sw->con_save_screen(vc);
 }
 
+#ifndef VT_BUF_VRAM_ONLY
+/*
+ * Number of cells starting at p, at most count, that carry the same
+ * attribute byte as the first one.  Where the screen buffer is plain
+ * memory it is compared a long at a time, i.e. 2 or 4 cells per step.
+ */
+static inline int attr_run(const u16 *p, int count)
+{
+	u16 attrib = scr_readw(p) & 0xff00;
+	int n = 1;
+#ifndef VT_BUF_HAVE_RW
+	const unsigned long ones = ~0UL / 0xffff;	/* 0x...00010001 */
+	const unsigned long pattern = ones * attrib;
+	const unsigned long mask = ones * 0xff00;
+	const int step = sizeof(unsigned long) / sizeof(u16);
+
+	while (n < count && ((unsigned long) (p + n) & (sizeof(unsigned long) - 1))) {
+		if ((p[n] & 0xff00) != attrib)
+			return n;
+		n++;
+	}
+	while (n + step <= count &&
+	       !((*(const unsigned long *) (p + n) ^ pattern) & mask))
+		n += step;
+#endif
+	while (n < count && (scr_readw(p + n) & 0xff00) == attrib)
+		n++;
+	return n;
+}
+#endif
+
 void do_update_region(struct vc_data *vc, unsigned long start, int count)
 {
 #ifndef VT_BUF_VRAM_ONLY
@@ -538,23 +779,19 @@ void do_update_region(struct vc_data *vc, unsigned long start, int count)
 		xx = nxx; yy = nyy;
 	}
 	for(;;) {
-		u16 attrib = scr_readw(p) & 0xff00;
-		int startx = xx;
-		u16 *q = p;
-		while (xx < vc->vc_cols && count) {
-			if (attrib != (scr_readw(p) & 0xff00)) {
-				if (p > q)
-					sw->con_putcs(vc, q, p-q, yy, startx);
-				startx = xx;
-				q = p;
-				attrib = scr_readw(p) & 0xff00;
-			}
-			p++;
-			xx++;
-			count--;
+		int left = min_t(int, vc->vc_cols - xx, count);
+
+		while (left > 0) {
+			int run = attr_run(p, left);
+
+			sw->con_putcs(vc, p, run, yy, xx);
+			vc->vc_stats.putcs++;
+			vc->vc_stats.cells += run;
+			p += run;
+			xx += run;
+			count -= run;
+			left -= run;
 		}
-		if (p > q)
-			sw->con_putcs(vc, q, p-q, yy, startx);
 		if (!count)
 			break;
 		xx = 0;
@@ -569,7 +806,7 @@ void do_update_region(struct vc_data *vc, unsigned long start, int count)
 
 void update_region(struct vc_data *vc, unsigned long start, int count)
 {
-	WARN_CONSOLE_UNLOCKED();
+	WARN_VT_UNLOCKED(vc->display_fg);
 
 	if (DO_UPDATE) {
 		hide_cursor(vc);
@@ -600,8 +837,11 @@ void update_screen(struct vc_data *vc)
 		update_attr(vc);
 		clear_buffer_attributes(vc);
 	}
-	if (update && vc->vc_mode != KD_GRAPHICS)
+	if (update && vc->vc_mode != KD_GRAPHICS) {
 		do_update_region(vc, vc->vc_origin, vc->vc_screenbuf_size/2);
+		vc_reset_damage(vc);
+	} else
+		vc_flush_damage(vc);
 	set_cursor(vc);
 }
 
@@ -623,7 +863,7 @@ void invert_screen(struct vc_data *vc, int offset, int count, int viewed)
 {
 	unsigned short *p;
 
-	WARN_CONSOLE_UNLOCKED();
+	WARN_VT_UNLOCKED(vc->display_fg);
 
 	count /= 2;
 	p = screenpos(vc, offset, viewed);
@@ -679,7 +919,7 @@ void complement_pos(struct vc_data *vc, int offset)
 	static unsigned short oldx, oldy, old;
 	static unsigned short *p;
 
-	WARN_CONSOLE_UNLOCKED();
+	WARN_VT_UNLOCKED(vc->display_fg);
 
 	if (p) {
 		scr_writew(old, p);
@@ -733,7 +973,7 @@ void do_blank_screen(struct vt_struct *vt, int entering_gfx)
 	struct vc_data *vc = vt->fg_console;
 	int i;
 
-	WARN_CONSOLE_UNLOCKED();
+	WARN_VT_UNLOCKED(vt);
 
 	if (vt->vt_blanked) {
 		if (vt->blank_state == blank_vesa_wait) {
@@ -851,7 +1091,7 @@ void poke_blanked_console(struct vt_struct *vt)
 {
 	struct vc_data *vc = vt->fg_console;
 
-	WARN_CONSOLE_UNLOCKED();
+	WARN_VT_UNLOCKED(vt);
 
 	del_timer(&vt->timer);
 	vt->blank_timer_expired = 0;
@@ -881,7 +1121,7 @@ static void vt_callback(void *private)
 	if (!vt || !vt->want_vc || !vt->want_vc->vc_tty)
 		return;
 
-	acquire_console_sem();
+	acquire_vt_sem(vt);
 
 	if ((vt->want_vc != vt->fg_console) && !vt->vt_dont_switch) {
 		hide_cursor(vt->fg_console);
@@ -896,16 +1136,21 @@ static void vt_callback(void *private)
 	}
 	if (vt->scrollback_delta) {
 		struct vc_data *vc = vt->fg_console;
-		clear_selection();
-		if (vc->vc_mode == KD_TEXT)
-			sw->con_scroll(vc, vt->scrollback_delta);
+		if (vc == sel_cons)
+			clear_selection();
+		if (vc->vc_mode == KD_TEXT) {
+			if (vc->vc_sb_buf)
+				vc_sb_scroll(vc, vt->scrollback_delta);
+			else
+				sw->con_scroll(vc, vt->scrollback_delta);
+		}
 		vt->scrollback_delta = 0;
 	}
 	if (vt->blank_timer_expired) {
 		do_blank_screen(vt, 0);
 		vt->blank_timer_expired = 0;
 	}
-	release_console_sem();
+	release_vt_sem(vt);
 }
 
 inline void set_console(struct vc_data *vc)
@@ -943,22 +1188,31 @@ static void vc_init(struct vc_data *vc, int do_clear)
 	vc->vc_def_color = 0x07;	/* white */
 	vc->vc_ulcolor = 0x0f;		/* bold white */
 	vc->vc_halfcolor = 0x08;	/* grey */
-	init_waitqueue_head(&vc->paste_wait);
+	init_MUTEX(&vc->vc_paste_sem);
+	INIT_WORK(&vc->vc_paste_work, paste_work, vc);
 	vte_ris(vc, do_clear);
 }
 
-struct vc_data *find_vc(int currcons)
+/* The display console currcons is on, whether it is allocated or not */
+struct vt_struct *find_vt(int currcons)
 {
 	struct vt_struct *vt;
 
 	list_for_each_entry(vt, &vt_list, node) {
 		if ((currcons < vt->first_vc + vt->vc_count) &&
 		    currcons >= vt->first_vc)
-			return vt->vc_cons[currcons - vt->first_vc];
+			return vt;
 	}
 	return NULL;
 }
 
+struct vc_data *find_vc(int currcons)
+{
+	struct vt_struct *vt = find_vt(currcons);
+
+	return vt ? vt->vc_cons[currcons - vt->first_vc] : NULL;
+}
+
 struct vc_data *vc_allocate(unsigned int currcons)
 {
 	struct vc_data *vc = NULL;
@@ -1011,6 +1265,7 @@ found_pool:
 			currcons = -ENOMEM;
 			return NULL;
 		}
+		vc->vc_damage_map = kmalloc(VC_DAMAGE_SIZE(vc->vc_rows), GFP_KERNEL);
 		vt->kmalloced = 1;
 		if (!*vc->vc_uni_pagedir_loc)
 			con_set_default_unimap(vc);
@@ -1021,7 +1276,11 @@ found_pool:
 			currcons = -ENOMEM;
 			return NULL;
 		}
+		vc->vc_damage_map = alloc_bootmem(VC_DAMAGE_SIZE(vc->vc_rows));
 	}
+	/* without a damage map output is drawn right away */
+	vc->vc_damage_rows = vc->vc_damage_map ? vc->vc_rows : 0;
+	vc_reset_damage(vc);
 	vt->vc_cons[currcons - vt->first_vc] = vc;
 	if ((vt->first_vc) == currcons)
 		vt->want_vc = vt->fg_console = vt->last_console = vc;
@@ -1036,10 +1295,17 @@ int vc_disallocate(struct vc_data *vc)
 	WARN_CONSOLE_UNLOCKED();
 
 	if (vc && vc->vc_num > MIN_NR_CONSOLES) {
+		/* /dev/vcs pollers wake up to find it gone */
+		vcs_scr_updated(vc);
+		kbd_drop_pending(vc);
 		sw->con_deinit(vc);
 		vt->vc_cons[vc->vc_num - vt->first_vc] = NULL;
-		if (vt->kmalloced)
-			kfree(screenbuf);
+		if (vt->kmalloced) {
+			kfree(vc->vc_screenbuf);
+			kfree(vc->vc_damage_map);
+		}
+		vc_sb_free(vc);
+		kfree(vc->vc_paste_buf);
 		kfree(vc);
 	}
 	return 0;
@@ -1071,12 +1337,12 @@ void reset_vc(struct vc_data *vc)
 
 int vc_resize(struct vc_data *vc, unsigned int cols, unsigned int lines)
 {
-	unsigned int old_cols, old_rows, old_screenbuf_size, old_row_size;
+	unsigned int old_cols, old_rows, old_row_size;
 	unsigned long ol, nl, nlend, rlth, rrem;
 	unsigned int new_cols, new_rows, ss, new_row_size, err = 0;
-	unsigned short *newscreen;
+	unsigned short *newscreen, *newdamage;
 
-	WARN_CONSOLE_UNLOCKED();
+	WARN_VT_UNLOCKED(vc->display_fg);
 
 	if (!vc)
 		return 0;
@@ -1092,18 +1358,21 @@ int vc_resize(struct vc_data *vc, unsigned int cols, unsigned int lines)
 	if (new_cols == vc->vc_cols && new_rows == vc->vc_rows)
 		return 0;
 
+	vc_sb_reset(vc);
+
 	newscreen = (unsigned short *) kmalloc(ss, GFP_USER);
 	if (!newscreen) 
 		return -ENOMEM;
+	newdamage = kmalloc(VC_DAMAGE_SIZE(new_rows), GFP_USER);
 
 	old_rows = vc->vc_rows;
 	old_cols = vc->vc_cols;
 	old_row_size = vc->vc_size_row;
-	old_screenbuf_size = vc->vc_screenbuf_size;
 
 	err = resize_screen(vc, new_cols, new_rows);
 	if (err) {
 		resize_screen(vc, old_cols, old_rows);
+		kfree(newdamage);
 		kfree(newscreen);
 		return err;
 	}
@@ -1132,12 +1401,19 @@ int vc_resize(struct vc_data *vc, unsigned int cols, unsigned int lines)
 	}
 	if (nlend > nl)
 		scr_memsetw((void *) nl, vc->vc_video_erase_char, nlend - nl);
-	if (vc->display_fg->kmalloced)
+	if (vc->display_fg->kmalloced) {
 		kfree(vc->vc_screenbuf);
+		kfree(vc->vc_damage_map);
+	}
 	vc->vc_screenbuf = newscreen;
+	vc->vc_damage_map = newdamage;
+	vc->vc_damage_rows = newdamage ? new_rows : 0;
+	vc_reset_damage(vc);
 	vc->display_fg->kmalloced = 1;
 	vc->vc_screenbuf_size = ss;
 	set_origin(vc);
+	if (vc->vc_sb_buf)
+		vc_sb_alloc(vc);
 
 	/* do part of a reset_terminal() */
 	vc->vc_top = 0;
@@ -1160,6 +1436,7 @@ int vc_resize(struct vc_data *vc, unsigned int cols, unsigned int lines)
 
 	if (IS_VISIBLE)
 		update_screen(vc);
+	vcs_scr_updated(vc);
 	return 0;
 }
 
@@ -1192,64 +1469,220 @@ int mouse_reporting(struct vc_data *vc)
  * kernel memory allocation is available.
  */
 
+#ifdef CONFIG_VT_CONSOLE
+static struct vc_data *print_vc(void)
+{
+	struct vc_data *vc = find_vc(kmsg_redirect);
+
+	return vc ? vc : admin_vt->fg_console;
+}
+#endif
+
+/*
+ * Display locking.  Rendering to a display and changing the state of
+ * its VCs is serialized by the display's own lock, and console_sem is
+ * always taken with it: the unimaps and their caches, the selection
+ * and printk are shared by all displays and only console_sem covers
+ * them.  What the display lock adds is that a long write can give
+ * console_sem up between slices and still keep its display to itself.
+ *
+ * The display lock is always taken before console_sem.
+ */
+void acquire_vt_sem(struct vt_struct *vt)
+{
+	down(&vt->lock);
+	acquire_console_sem();
+	vt->vt_locked = 1;
+	vt->vt_locked_at = sched_clock();
+}
+
+void release_vt_sem(struct vt_struct *vt)
+{
+	vt->vt_locked = 0;
+	release_console_sem();
+	up(&vt->lock);
+}
+
+/*
+ * A long write gives console_sem up every VT_WRITE_SLICE bytes, so that
+ * kernel messages and output to the other displays are not held off
+ * behind it.  The display lock is kept, so the VC's own state stays
+ * put, but anything that only needs console_sem can run in between:
+ * printk and vt_print_flush(), the selection being set or cleared from
+ * another display, unimap and translation changes made through another
+ * display.  The glyph table is looked up for every run anyway; the font
+ * mask and cell attribute are recomputed after each slice.
+ */
+#define VT_WRITE_SLICE	512
+
+/*
+ * Decode one complete two to four byte UTF-8 sequence for the plain
+ * text path of do_con_write() and look up its glyph the way the byte
+ * decoder would.  Returns the number of bytes used, or 0 to leave it
+ * to the byte decoder: partial or malformed sequences (which it has to
+ * carry or drop), and anything decoding to a control.
+ */
+static inline int utf8_glyph(struct vc_data *vc, const unsigned char *s,
+			     int left, int *glyph)
+{
+	unsigned int c = s[0];
+	int i, len, tc;
+
+	len = c < 0xc0 ? 0 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : c < 0xf8 ? 4 : 0;
+	if (!len || len > left)
+		return 0;
+	c &= 0x7f >> len;
+	for (i = 1; i < len; i++) {
+		if ((s[i] & 0xc0) != 0x80)
+			return 0;
+		c = (c << 6) | (s[i] & 0x3f);
+	}
+	if (c < 0xa0)
+		return 0;
+	tc = conv_uni_to_pc(vc, c);
+	if (tc == -4) {
+		tc = conv_uni_to_pc(vc, 0xfffd);
+		if (tc == -4)
+			tc = c;
+	} else if (tc == -3)
+		tc = c;
+	*glyph = tc;
+	return len;
+}
+
+/*
+ * The attribute half of a screen cell only changes with vc_attr or the
+ * font, so do_con_write() builds it once and just adds each glyph; with
+ * a 512 glyph font bit 8 of the glyph goes to the hi font bit.
+ */
+#define CELL_ATTR(vc, himask)	((u16) (((vc)->vc_attr << 8) & ~(himask)))
+#define CELL(cell, himask, tc)	((cell) + ((tc) & 0xff) + (((tc) & 0x100) ? (himask) : 0))
+
 static int do_con_write(struct tty_struct *tty, const unsigned char *buf, int count)
 {
 #ifdef VT_BUF_VRAM_ONLY
 #define FLUSH do { } while(0);
 #else
-#define FLUSH if (draw_x >= 0 && sw->con_putcs) { \
-	sw->con_putcs(vc, (u16 *)draw_from, (u16 *)draw_to-(u16 *)draw_from, vc->vc_y, draw_x); \
+#define FLUSH if (draw_x >= 0) { \
+	vc_damage(vc, vc->vc_y, draw_x, (u16 *)draw_to-(u16 *)draw_from); \
 	draw_x = -1; \
 	}
 #endif
 	unsigned long draw_from = 0, draw_to = 0;
 	struct vc_data *vc = tty->driver_data;
-	const unsigned char *orig_buf = NULL;
-	int c, tc, ok, n = 0, draw_x = -1;
-	u16 himask, charmask;
-	int orig_count;
+	int c, tc, ok, n = 0, slice = 0, draw_x = -1;
+	struct vt_struct *vt;
+	u16 himask, charmask, cell;
+	const u16 *glyphs;
 
 	if (in_interrupt())
 		return count;
 
 	might_sleep();
 
-	acquire_console_sem();
-
+	/* vt_close() clears driver_data under the display lock */
 	if (!vc) {
 		printk("vt_write: tty %d not allocated\n", tty->index);
-		release_console_sem();
 		return 0;
 	}
-	release_console_sem();
-	
-	orig_buf = buf;
-	orig_count = count;
+	vt = vc->display_fg;
 
 	/* At this point 'buf' is guaranteed to be a kernel buffer
 	 * and therefore no access to userspace (and therefore sleeping)
-	 * will be needed.  The VT buffer lock serializes all tty based
-	 * console rendering and vcs write/read operations.  We hold
-	 * the console spinlock during the entire write.
+	 * will be needed.  The display lock serializes all tty based
+	 * console rendering and vcs write/read operations.
 	 */
 
-	acquire_console_sem();
+	acquire_vt_sem(vt);
+	if (tty->driver_data != vc) {
+		release_vt_sem(vt);
+		return 0;
+	}
+	vc_sb_reset(vc);
 
 	himask = vc->vc_hi_font_mask;
 	charmask = himask ? 0x1ff : 0xff;
+	cell = CELL_ATTR(vc, himask);
 
 	/* undraw cursor first */
 	if (IS_VISIBLE)
 		hide_cursor(vc);
 
 	while (!tty->stopped && count) {
+		if (n - slice >= VT_WRITE_SLICE) {
+			slice = n;
+			/* Damage pending stays; printk adds to it */
+			FLUSH
+			vc->vc_stats.write_ns += sched_clock() -
+						 vt->vt_locked_at;
+			release_console_sem();
+			cond_resched();
+			acquire_console_sem();
+			vt->vt_locked_at = sched_clock();
+			vc_sb_reset(vc);
+			himask = vc->vc_hi_font_mask;
+			charmask = himask ? 0x1ff : 0xff;
+			cell = CELL_ATTR(vc, himask);
+			if (IS_VISIBLE)
+				hide_cursor(vc);
+		}
+		/*
+		 * Plain text goes through the cached glyph table straight
+		 * into the screen buffer, up to the end of the line.  The
+		 * next FLUSH records the whole run as a single span of
+		 * damage.  In UTF-8 mode whole multibyte characters are
+		 * decoded in place.  Anything the table doesn't know
+		 * about ends the run and is handled one byte at a time
+		 * below.
+		 */
+		if (!vc->vc_state && !vc->vc_need_wrap && !vc->vc_irm &&
+		    !vc->vc_toggle_meta && (glyphs = con_glyph_table(vc))) {
+			u16 *p = (u16 *) vc->vc_pos;
+			int room = vc->vc_cols - vc->vc_x;
+			int utf = vc->vc_utf && !vc->vc_utf_count;
+			int run = 0, i = 0, len = 1;
+
+			while (i < count && run < room) {
+				if (buf[i] < 0x80 || !utf)
+					tc = glyphs[buf[i]];
+				else if (!(len = utf8_glyph(vc, buf + i, count - i, &tc)))
+					break;
+				if (tc & ~charmask)
+					break;
+				scr_writew(CELL(cell, himask, tc), p + run);
+				run++;
+				i += len;
+				len = 1;
+			}
+			if (run) {
+				if (DO_UPDATE && draw_x < 0) {
+					draw_x = vc->vc_x;
+					draw_from = vc->vc_pos;
+				}
+				vc->vc_utf_count = 0;
+				buf += i;
+				n += i;
+				count -= i;
+				if (run == room) {
+					vc->vc_x = vc->vc_cols - 1;
+					vc->vc_pos += 2 * (run - 1);
+					vc->vc_need_wrap = vc->vc_decawm;
+					draw_to = vc->vc_pos + 2;
+				} else {
+					vc->vc_x += run;
+					draw_to = (vc->vc_pos += 2 * run);
+				}
+				continue;
+			}
+		}
+
 		c = *buf;
 		buf++;
 		n++;
 		count--;
 
 		/* Do no translation at all in control states */
-		if (!vc->vc_state) {
+		if (vc->vc_state) {
 			tc = c;
 		} else if (vc->vc_utf) {
 		    /* Combine UTF-8 into Unicode */
@@ -1333,8 +1766,7 @@ static int do_con_write(struct tty_struct *tty, const unsigned char *buf, int co
 			}
 			if (vc->vc_irm)
 				insert_char(vc, 1);
-			scr_writew(himask ?
-				     ((vc->vc_attr << 8) & ~himask) + ((tc & 0x100) ? himask : 0) + (tc & 0xff) : (vc->vc_attr << 8) + tc, (u16 *) vc->vc_pos);
+			scr_writew(CELL(cell, himask, tc), (u16 *) vc->vc_pos);
 			if (DO_UPDATE && draw_x < 0) {
 				draw_x = vc->vc_x;
 				draw_from = vc->vc_pos;
@@ -1349,11 +1781,17 @@ static int do_con_write(struct tty_struct *tty, const unsigned char *buf, int co
 			continue;
 		}
 		FLUSH
-		terminal_emulation(tty, c);
+		terminal_emulation(vc, c);
+		cell = CELL_ATTR(vc, himask);
 	}
 	FLUSH
+	vc_flush_damage(vc);
+	if (n)
+		vcs_scr_updated(vc);
+	vc->vc_stats.bytes += n;
 	console_conditional_schedule();
-	release_console_sem();
+	vc->vc_stats.write_ns += sched_clock() - vt->vt_locked_at;
+	release_vt_sem(vt);
 	return n;
 #undef FLUSH
 }
@@ -1375,6 +1813,8 @@ static int vt_open(struct tty_struct *tty, struct file *filp)
 		if (vc) {
 			tty->driver_data = vc;
 			vc->vc_tty = tty;
+			if (!vc->vc_sb_buf)
+				vc_sb_alloc(vc);
 
 			if (!tty->winsize.ws_row && !tty->winsize.ws_col) {
 				tty->winsize.ws_row = vc->vc_rows;
@@ -1397,13 +1837,20 @@ static int vt_open(struct tty_struct *tty, struct file *filp)
 static void vt_close(struct tty_struct *tty, struct file * filp)
 {
 	down(&tty_sem);
-	acquire_console_sem();
 	if (tty && tty->count == 1) {
 		struct vc_data *vc = tty->driver_data;
-		if (vc)
+
+		if (vc) {
+			/* nothing may be pasted into the tty once it is gone */
+			paste_cancel(vc);
+			/* nor written to it */
+			acquire_vt_sem(vc->display_fg);
 			vc->vc_tty = NULL;
-		tty->driver_data = NULL;
-		release_console_sem();
+			tty->driver_data = NULL;
+			release_vt_sem(vc->display_fg);
+			/* nor pushed to by the keyboard */
+			kbd_drop_pending(vc);
+		}
 		vcs_remove_devfs(tty);
 		up(&tty_sem);
 		/*
@@ -1412,7 +1859,6 @@ static void vt_close(struct tty_struct *tty, struct file * filp)
 		 */
 		return;
 	}
-	release_console_sem();
 	up(&tty_sem);
 }
 
@@ -1447,11 +1893,13 @@ static void vt_flush_chars(struct tty_struct *tty)
 		return;
 
 	/* if we race with vt_close(), vc may be null */
-	acquire_console_sem();
 	vc = tty->driver_data;
-	if (vc)
+	if (!vc)
+		return;
+	acquire_vt_sem(vc->display_fg);
+	if (tty->driver_data)
 		set_cursor(vc);
-	release_console_sem();
+	release_vt_sem(vc->display_fg);
 }
 
 static int vt_chars_in_buffer(struct tty_struct *tty)
@@ -1473,7 +1921,7 @@ static void vt_stop(struct tty_struct *tty)
 	if (!vc)
 		return;
 	set_kbd_led(&vc->kbd_table, VC_SCROLLOCK);
-	set_leds();
+	set_leds(vc);
 }
 
 /*
@@ -1490,7 +1938,7 @@ static void vt_start(struct tty_struct *tty)
 	if (!vc) 	
 		return;
 	clr_kbd_led(&vc->kbd_table, VC_SCROLLOCK);
-	set_leds();
+	set_leds(vc);
 }
 
 /*
@@ -1506,11 +1954,37 @@ static void vt_unthrottle(struct tty_struct *tty)
 {
 	struct vc_data *vc = tty->driver_data;
 
-	wake_up_interruptible(&vc->paste_wait);
+	if (vc->vc_paste_buf)
+		schedule_work(&vc->vc_paste_work);
 }
 
 #ifdef CONFIG_VT_CONSOLE
 
+/*
+ * Kernel messages only go to the screen buffer; the display is brought
+ * up to date at most every VT_PRINT_DELAY, so a log storm costs one
+ * redraw per tick rather than one per line.  An oops or panic flushes
+ * at once, as does everything before keventd is up.
+ */
+#define VT_PRINT_DELAY	(HZ / 50)
+
+static int print_deferred;
+
+static void vt_print_flush(void *unused)
+{
+	struct vc_data *vc;
+
+	acquire_console_sem();
+	vc = print_vc();
+	if (vc->vc_mode == KD_TEXT) {
+		vc_flush_damage(vc);
+		set_cursor(vc);
+	}
+	release_console_sem();
+}
+
+static DECLARE_WORK(vt_print_work, vt_print_flush, NULL);
+
 /*
  *	Console on virtual terminal
  *
@@ -1519,9 +1993,8 @@ static void vt_unthrottle(struct tty_struct *tty)
 
 void vt_console_print(struct console *co, const char *b, unsigned count)
 {
-	struct vc_data *vc = find_vc(kmsg_redirect);
+	struct vc_data *vc = print_vc();
 	static unsigned long printing;
-	const ushort *start;
 	ushort myx, cnt = 0;
 	unsigned char c;
 
@@ -1529,9 +2002,6 @@ void vt_console_print(struct console *co, const char *b, unsigned count)
 	if (!printable || test_and_set_bit(0, &printing))
 		return;
 
-	if (!vc)
-		vc = admin_vt->fg_console;
-
 	/* read `x' only after setting currcons properly (otherwise
 	   the `x' macro will read the x of the foreground console). */
 	myx = vc->vc_x;
@@ -1539,11 +2009,28 @@ void vt_console_print(struct console *co, const char *b, unsigned count)
 	if (vc->vc_mode != KD_TEXT)
 		goto quit;
 
+	vc_sb_reset(vc);
+
 	/* undraw cursor first */
 	if (IS_VISIBLE)
 		hide_cursor(vc);
 
-	start = (ushort *)vc->vc_pos;
+	/*
+	 * At the bottom of the scroll region make room for all the
+	 * newlines up front, one scroll instead of one per line.
+	 */
+	if (vc->vc_y + 1 == vc->vc_bottom) {
+		unsigned int i, nr = 0;
+
+		for (i = 0; i < count && nr < vc->vc_bottom - vc->vc_top - 1; i++)
+			if (b[i] == 10)
+				nr++;
+		if (nr > 1) {
+			scroll_region_up(vc, vc->vc_top, vc->vc_bottom, nr);
+			vc->vc_y -= nr;
+			vc->vc_pos -= nr * vc->vc_size_row;
+		}
+	}
 
 	/* Contrived structure to try to emulate original need_wrap behaviour
 	 * Problems caused when we have need_wrap set on '\n' character */
@@ -1551,8 +2038,7 @@ void vt_console_print(struct console *co, const char *b, unsigned count)
 		c = *b++;
 		if (c == 10 || c == 13 || c == 8 || vc->vc_need_wrap) {
 			if (cnt > 0) {
-				if (IS_VISIBLE)
-					sw->con_putcs(vc, start, cnt, vc->vc_y, vc->vc_x);
+				vc_damage(vc, vc->vc_y, vc->vc_x, cnt);
 				vc->vc_x += cnt;
 				if (vc->vc_need_wrap)
 					vc->vc_x--;
@@ -1560,14 +2046,12 @@ void vt_console_print(struct console *co, const char *b, unsigned count)
 			}
 			if (c == 8) {		/* backspace */
 				vte_bs(vc);
-				start = (ushort *)vc->vc_pos;
 				myx = vc->vc_x;
 				continue;
 			}
 			if (c != 13)
 				vte_lf(vc);
 			vte_cr(vc);
-			start = (ushort *)vc->vc_pos;
 			myx = vc->vc_x;
 			if (c == 10 || c == 13)
 				continue;
@@ -1582,15 +2066,19 @@ void vt_console_print(struct console *co, const char *b, unsigned count)
 		myx++;
 	}
 	if (cnt > 0) {
-		if (IS_VISIBLE)
-			sw->con_putcs(vc, start, cnt, vc->vc_y, vc->vc_x);
+		vc_damage(vc, vc->vc_y, vc->vc_x, cnt);
 		vc->vc_x += cnt;
 		if (vc->vc_x == vc->vc_cols) {
 			vc->vc_x--;
 			vc->vc_need_wrap = 1;
 		}
 	}
-	set_cursor(vc);
+	vcs_scr_updated(vc);
+	if (oops_in_progress || !print_deferred) {
+		vc_flush_damage(vc);
+		set_cursor(vc);
+	} else
+		schedule_delayed_work(&vt_print_work, VT_PRINT_DELAY);
 
 	if (!oops_in_progress)
 		poke_blanked_console(vc->display_fg);
@@ -1646,9 +2134,9 @@ int tioclinux(struct tty_struct *tty, unsigned long arg)
 	switch (type)
 	{
 		case TIOCL_SETSEL:
-			acquire_console_sem();
+			acquire_vt_sem(vc->display_fg);
 			ret = set_selection((struct tiocl_selection __user *)(p+1), tty);
-			release_console_sem();
+			release_vt_sem(vc->display_fg);
 			break;
 		case TIOCL_PASTESEL:
 			ret = paste_selection(tty);
@@ -1667,7 +2155,7 @@ int tioclinux(struct tty_struct *tty, unsigned long arg)
 	 * kernel-internal variable; programs not closely
 	 * related to the kernel should not use this.
 	 */
-	 		data = shift_state;
+	 		data = vc->display_fg->kbd_state.shift_state;
 			ret = __put_user(data, p);
 			break;
 		case TIOCL_GETMOUSEREPORTING:
@@ -1683,10 +2171,13 @@ int tioclinux(struct tty_struct *tty, unsigned long arg)
 			if (!capable(CAP_SYS_ADMIN)) {
 				ret = -EPERM;
 			} else {
-				if (get_user(data, p+1))
+				if (get_user(data, p+1)) {
 					ret = -EFAULT;
-				else
+				} else {
+					acquire_console_sem();
 					kmsg_redirect = data;
+					release_console_sem();
+				}
 			}
 			break;
 		case TIOCL_GETFGCONSOLE:
@@ -1702,7 +2193,9 @@ int tioclinux(struct tty_struct *tty, unsigned long arg)
 			break;
 		case TIOCL_BLANKSCREEN: /* until explicitly unblanked, not only poked */
 			ignore_poke = 1;
+			acquire_vt_sem(vc->display_fg);
 			do_blank_screen(vc->display_fg, 0);
+			release_vt_sem(vc->display_fg);
 			break;
 		case TIOCL_BLANKEDSCREEN:	
 			ret = vc->display_fg->vt_blanked;
@@ -1746,6 +2239,7 @@ const char *vt_map_display(struct vt_struct *vt, int init, int vc_count)
 	vt->timer.function = blank_screen_t;
 	mod_timer(&vt->timer, jiffies + vt->blank_interval);
 	vt->keyboard = NULL;
+	INIT_LIST_HEAD(&vt->led_node);
 	INIT_WORK(&vt->vt_work, vt_callback, vt);
 
 	if (!admin_vt) {
@@ -1755,12 +2249,12 @@ const char *vt_map_display(struct vt_struct *vt, int init, int vc_count)
 		printable = 1;
 #endif
 	}
-	acquire_console_sem();
+	acquire_vt_sem(vt);
 	vt->vc_cons[0] = vc_allocate(current_vc);
 	gotoxy(vt->fg_console, vt->fg_console->vc_x, vt->fg_console->vc_y);
 	vte_ed(vt->fg_console, 0);
 	update_screen(vt->fg_console);
-	release_console_sem();
+	release_vt_sem(vt);
 	current_vc += vc_count;
 	current_vt += 1;
 	if (vt->kmalloced) {
@@ -1842,6 +2336,9 @@ int __init vty_init(void)
 #ifdef CONFIG_PROC_FS
         vt_proc_init();
 #endif
+#ifdef CONFIG_VT_CONSOLE
+	print_deferred = 1;
+#endif
 #if defined (CONFIG_PROM_CONSOLE)
 	prom_con_init();
 #endif
@@ -1871,7 +2368,7 @@ int take_over_console(struct vt_struct *vt, const struct consw *csw)
 		return -ENODEV;
 
 	/* First shutdown old console driver */
-	acquire_console_sem();
+	acquire_vt_sem(vt);
 	hide_cursor(vc);
 
 	for (i = 0; i < vt->vc_count; i++) {
@@ -1889,7 +2386,7 @@ int take_over_console(struct vt_struct *vt, const struct consw *csw)
 	if (!desc) {
 		/* Make sure the original driver state is restored to normal */
 		vt->vt_sw->con_startup(vt, 1);
-		release_console_sem();
+		release_vt_sem(vt);
 		module_put(owner);
 		return -ENODEV;
 	}
@@ -1907,7 +2404,7 @@ int take_over_console(struct vt_struct *vt, const struct consw *csw)
 			vc->vc_origin = (unsigned long) vc->vc_screenbuf;
 			vc->vc_visible_origin = vc->vc_origin;
 			vc->vc_scr_end = vc->vc_origin + vc->vc_screenbuf_size;
-			vc->vc_pos = vc->vc_origin + vc->vc_size_rows * vc->vc_y + 2 * vc->vc_x;
+			vc->vc_pos = vc->vc_origin + vc->vc_size_row * vc->vc_y + 2 * vc->vc_x;
 			visual_init(vc, 0);
 			update_attr(vc);
 
@@ -1926,7 +2423,7 @@ int take_over_console(struct vt_struct *vt, const struct consw *csw)
 			vc->vc_can_do_color ? "colour" : "mono",
 			desc, vc->vc_cols, vc->vc_rows,
 			vt->first_vc + 1, vt->first_vc + vt->vc_count);
-	release_console_sem();
+	release_vt_sem(vt);
 	module_put(owner);
 	return 0;
 }
@@ -1947,4 +2444,5 @@ EXPORT_SYMBOL(update_region);
 EXPORT_SYMBOL(update_screen);
 EXPORT_SYMBOL(vt_map_display);
 EXPORT_SYMBOL(admin_vt);
+EXPORT_SYMBOL(find_vt);
 EXPORT_SYMBOL(find_vc);
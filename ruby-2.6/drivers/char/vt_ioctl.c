@@ -126,6 +126,7 @@ do_kdsk_ioctl(struct vc_data *vc, int cmd, struct kbentry __user *user_kbe, int
 			key_map = key_maps[s];
 			if (s && key_map) {
 				key_maps[s] = NULL;
+				kbd_keymap_changed(s);
 				if (key_map[0] == U(K_ALLOCATED)) {
 					kfree(key_map);
 					keymap_count--;
@@ -172,8 +173,14 @@ do_kdsk_ioctl(struct vc_data *vc, int cmd, struct kbentry __user *user_kbe, int
 		if (((ov == K_SAK) || (v == K_SAK)) && !capable(CAP_SYS_ADMIN))
 			return -EPERM;
 		key_map[i] = U(v);
-		if (!s && (KTYP(ov) == KT_SHIFT || KTYP(v) == KT_SHIFT))
-			compute_shiftstate();
+		kbd_keymap_changed(s);
+		if (!s && (KTYP(ov) == KT_SHIFT || KTYP(v) == KT_SHIFT)) {
+			struct vt_struct *vt;
+
+			/* the keymaps are shared by all seats */
+			list_for_each_entry(vt, &vt_list, node)
+				compute_shiftstate(vt);
+		}
 		break;
 	}
 	return 0;
@@ -340,12 +347,12 @@ int con_font_get(struct vc_data *vc, struct console_font_op *op)
 	} else
 		font.data = NULL;
 
-	acquire_console_sem();
+	acquire_vt_sem(vc->display_fg);
 	if (vc->display_fg->vt_sw->con_font_get)
 		rc = vc->display_fg->vt_sw->con_font_get(vc, &font);
 	else
 		rc = -ENOSYS;
-	release_console_sem();
+	release_vt_sem(vc->display_fg);
 
 	if (rc)
 		goto out;
@@ -425,12 +432,12 @@ nonzero:
 		kfree(font.data);
 		return -EFAULT;
 	}
-	acquire_console_sem();
+	acquire_vt_sem(vc->display_fg);
 	if (vc->display_fg->vt_sw->con_font_set)
 		rc = vc->display_fg->vt_sw->con_font_set(vc, &font, op->flags);
 	else
 		rc = -ENOSYS;
-	release_console_sem();
+	release_vt_sem(vc->display_fg);
 	kfree(font.data);
 	return rc;
 }
@@ -452,12 +459,12 @@ int con_font_default(struct vc_data *vc, struct console_font_op *op)
 	else
 		name[MAX_FONT_NAME - 1] = 0;
 
-	acquire_console_sem();
+	acquire_vt_sem(vc->display_fg);
 	if (vc->display_fg->vt_sw->con_font_default)
 		rc = vc->display_fg->vt_sw->con_font_default(vc, &font, s);
 	else
 		rc = -ENOSYS;
-	release_console_sem();
+	release_vt_sem(vc->display_fg);
 	if (!rc) {
 		op->width = font.width;
 		op->height = font.height;
@@ -473,7 +480,7 @@ int con_font_copy(struct vc_data *vc, struct console_font_op *op)
 	if (vc->vc_mode != KD_TEXT)
 		return -EINVAL;
 
-	acquire_console_sem();
+	acquire_vt_sem(vc->display_fg);
 	if (!vc->display_fg->vt_sw->con_font_copy)
 		rc = -ENOSYS;
 	else if (!find_vc(con))
@@ -482,7 +489,7 @@ int con_font_copy(struct vc_data *vc, struct console_font_op *op)
 		rc = 0;
 	else
 		rc = vc->display_fg->vt_sw->con_font_copy(vc, con);
-	release_console_sem();
+	release_vt_sem(vc->display_fg);
 	return rc;
 }
 
@@ -628,8 +635,8 @@ inline void switch_screen(struct vc_data *new_vc, struct vc_data *old_vc)
 					 new_vc->vc_screenbuf_size/2);
         }
         set_cursor(new_vc);
-        set_leds();
-        compute_shiftstate();
+        set_leds(new_vc);
+        compute_shiftstate(new_vc->display_fg);
 }
 
 /*
@@ -724,12 +731,10 @@ void complete_change_console(struct vc_data *new_vc, struct vc_data *old_vc)
 	 * controlling process is gone and we've called reset_vc.
 	 */
 	if (old_vc_mode != new_vc->vc_mode) {
-		acquire_console_sem();
 		if (new_vc->vc_mode == KD_TEXT)
 			unblank_vt(new_vc->display_fg);
 		else
 			do_blank_screen(new_vc->display_fg, 1);
-		release_console_sem();
 	}
 
 	/*
@@ -903,12 +908,12 @@ int vt_ioctl(struct tty_struct *tty, struct file * file,
 		/*
 		 * explicitly blank/unblank the screen if switching modes
 		 */
-		acquire_console_sem();
+		acquire_vt_sem(vc->display_fg);
 		if (arg == KD_TEXT)
 			unblank_vt(vc->display_fg);
 		else
 			do_blank_screen(vc->display_fg, 1);
-		release_console_sem();
+		release_vt_sem(vc->display_fg);
 		return 0;
 
 	case KDGETMODE:
@@ -935,11 +940,11 @@ int vt_ioctl(struct tty_struct *tty, struct file * file,
 			break;
 		  case K_XLATE:
 			vc->kbd_table.kbdmode = VC_XLATE;
-			compute_shiftstate();
+			compute_shiftstate(vc->display_fg);
 			break;
 		  case K_UNICODE:
 			vc->kbd_table.kbdmode = VC_UNICODE;
-			compute_shiftstate();
+			compute_shiftstate(vc->display_fg);
 			break;
 		  default:
 			return -EINVAL;
@@ -1029,7 +1034,7 @@ int vt_ioctl(struct tty_struct *tty, struct file * file,
 			return -EINVAL;
 		vc->kbd_table.ledflagstate = (arg & 7);
 		vc->kbd_table.default_ledflagstate = ((arg >> 4) & 7);
-		set_leds();
+		set_leds(vc);
 		return 0;
 
 	/* the ioctls below only set the lights, not the functions */
@@ -1074,14 +1079,14 @@ int vt_ioctl(struct tty_struct *tty, struct file * file,
 			return -EFAULT;
 		if (tmp.mode != VT_AUTO && tmp.mode != VT_PROCESS)
 			return -EINVAL;
-		acquire_console_sem();
+		acquire_vt_sem(vc->display_fg);
 		vc->vt_mode = tmp;
 		/* the frsig is ignored, so we set it to 0 */
 		vc->vt_mode.frsig = 0;
 		vc->vt_pid = current->pid;
 		/* no switch is required -- saw@shade.msu.ru */
 		vc->vt_newvt = -1;
-		release_console_sem();
+		release_vt_sem(vc->display_fg);
 		return 0;
 	}
 
@@ -1089,9 +1094,9 @@ int vt_ioctl(struct tty_struct *tty, struct file * file,
 	{
 		struct vt_mode tmp;
 
-		acquire_console_sem();
+		acquire_vt_sem(vc->display_fg);
 		memcpy(&tmp, &vc->vt_mode, sizeof(struct vt_mode));
-		release_console_sem();
+		release_vt_sem(vc->display_fg);
 		return copy_to_user(up, &tmp, sizeof(struct vt_mode)) ? -EFAULT : 0;
 	}
 
@@ -1209,13 +1214,13 @@ int vt_ioctl(struct tty_struct *tty, struct file * file,
 				 */
 				struct vc_data *tmp = find_vc(vc->vt_newvt); 
 								
-				acquire_console_sem();
+				acquire_vt_sem(vc->display_fg);
 				if (!tmp) {
 					tmp = vc_allocate(vc->vt_newvt);
 					if (!tmp) {
 						i = vc->vt_newvt;
 						vc->vt_newvt = -1;
-						release_console_sem();
+						release_vt_sem(vc->display_fg);
 						return i;
 					}
 				}
@@ -1226,7 +1231,7 @@ int vt_ioctl(struct tty_struct *tty, struct file * file,
 				 * other console switches..
 				 */
 				complete_change_console(tmp, vc->display_fg->fg_console);
-				release_console_sem();
+				release_vt_sem(vc->display_fg);
 			}
 		} else {
 			/*
@@ -1247,24 +1252,29 @@ int vt_ioctl(struct tty_struct *tty, struct file * file,
 
 		if (arg > MAX_NR_CONSOLES)
 			return -ENXIO;
+		/* under the display lock, which /dev/vcs users hold */
 		if (arg == 0) {
 			/* disallocate all unused consoles, but leave visible VC */
-			acquire_console_sem();
+			acquire_vt_sem(vt);
 			for (i = 1; i < vt->vc_count; i++) {
-				tmp = find_vc(i + vt->first_vc);
+				tmp = vt->vc_cons[i];
 		
 				if (tmp && !VT_BUSY(tmp)) 
 					vc_disallocate(tmp);
 			}
-			release_console_sem();
+			release_vt_sem(vt);
 		} else {
 			/* disallocate a single console, if possible */
-			tmp = find_vc(arg-1);
-			if (!tmp || VT_BUSY(tmp))
+			if (!(vt = find_vt(arg-1)))
 				return -EBUSY;
-			acquire_console_sem();
+			acquire_vt_sem(vt);
+			tmp = vt->vc_cons[arg-1 - vt->first_vc];
+			if (!tmp || VT_BUSY(tmp)) {
+				release_vt_sem(vt);
+				return -EBUSY;
+			}
 			vc_disallocate(tmp);
-			release_console_sem();
+			release_vt_sem(vt);
 		}
 		return 0;
 	}
@@ -1280,9 +1290,9 @@ int vt_ioctl(struct tty_struct *tty, struct file * file,
 		for (i = 0; i < vc->display_fg->vc_count; i++) {
 			struct vc_data *tmp = vc->display_fg->vc_cons[i];
 
-			acquire_console_sem();
+			acquire_vt_sem(vc->display_fg);
 			vc_resize(tmp, cc, ll);
-			release_console_sem();
+			release_vt_sem(vc->display_fg);
 		}
 		return 0;
 	}
@@ -1325,13 +1335,13 @@ int vt_ioctl(struct tty_struct *tty, struct file * file,
 		for (i = 0; i < vc->display_fg->vc_count; i++) {
 			struct vc_data *tmp = vc->display_fg->vc_cons[i];
 
-			acquire_console_sem();
+			acquire_vt_sem(vc->display_fg);
 			if (vlin)
 				tmp->vc_scan_lines = vlin;
 			if (clin)
 				tmp->vc_font.height = clin;
 			vc_resize(tmp, cc, ll);
-			release_console_sem();
+			release_vt_sem(vc->display_fg);
 		}
 		return 0;
 	}
@@ -7,6 +7,7 @@
 #include <linux/module.h>
 #include <linux/init.h>
 #include <linux/list.h>
+#include <linux/console.h>
 #include <linux/vt_kern.h>
 #include <linux/input.h>
 
@@ -45,6 +46,71 @@ vt_show_keyboard (struct class_device *dev, char *buf)
 }
 static CLASS_DEVICE_ATTR(keyboard, S_IRUGO, vt_show_keyboard, NULL);
 
+/*
+ * Activity counters.  "stats" sums up the VCs of the display, one
+ * counter per line; "vc_stats" has one line per allocated VC:
+ *	vc bytes escapes putcs cells scrolls write_ns paste_bytes paste_stall_ns
+ */
+static ssize_t
+vt_show_stats (struct class_device *dev, char *buf)
+{
+	struct vt_struct *vt;
+	struct vc_stats sum;
+	int i;
+
+	vt = to_vt_struct (dev);
+	memset(&sum, 0, sizeof(sum));
+	acquire_console_sem();
+	for (i = 0; i < vt->vc_count; i++) {
+		struct vc_data *vc = vt->vc_cons[i];
+
+		if (!vc)
+			continue;
+		sum.bytes += vc->vc_stats.bytes;
+		sum.escapes += vc->vc_stats.escapes;
+		sum.putcs += vc->vc_stats.putcs;
+		sum.cells += vc->vc_stats.cells;
+		sum.scrolls += vc->vc_stats.scrolls;
+		sum.write_ns += vc->vc_stats.write_ns;
+		sum.paste_bytes += vc->vc_stats.paste_bytes;
+		sum.paste_stall_ns += vc->vc_stats.paste_stall_ns;
+	}
+	release_console_sem();
+	return sprintf (buf, "bytes %lu\nescapes %lu\nputcs %lu\ncells %lu\n"
+			"scrolls %lu\nwrite_ns %llu\npaste_bytes %lu\n"
+			"paste_stall_ns %llu\n", sum.bytes, sum.escapes,
+			sum.putcs, sum.cells, sum.scrolls, sum.write_ns,
+			sum.paste_bytes, sum.paste_stall_ns);
+}
+static CLASS_DEVICE_ATTR(stats, S_IRUGO, vt_show_stats, NULL);
+
+static ssize_t
+vt_show_vc_stats (struct class_device *dev, char *buf)
+{
+	struct vt_struct *vt;
+	int i, len = 0;
+
+	vt = to_vt_struct (dev);
+	acquire_console_sem();
+	for (i = 0; i < vt->vc_count && len < PAGE_SIZE; i++) {
+		struct vc_data *vc = vt->vc_cons[i];
+
+		if (!vc)
+			continue;
+		len += snprintf (buf + len, PAGE_SIZE - len,
+				 "%u %lu %lu %lu %lu %lu %llu %lu %llu\n",
+				 vc->vc_num + 1,
+				 vc->vc_stats.bytes, vc->vc_stats.escapes,
+				 vc->vc_stats.putcs, vc->vc_stats.cells,
+				 vc->vc_stats.scrolls, vc->vc_stats.write_ns,
+				 vc->vc_stats.paste_bytes,
+				 vc->vc_stats.paste_stall_ns);
+	}
+	release_console_sem();
+	return min_t(int, len, PAGE_SIZE - 1);
+}
+static CLASS_DEVICE_ATTR(vc_stats, S_IRUGO, vt_show_vc_stats, NULL);
+
 int __init vt_create_sysfs_dev_files (struct vt_struct *vt)
 {
 	struct class_device *dev = &vt->dev;
@@ -58,6 +124,8 @@ int __init vt_create_sysfs_dev_files (struct vt_struct *vt)
 	class_device_create_file (dev, &class_device_attr_first_vc);
 	class_device_create_file (dev, &class_device_attr_vc_count);
 	class_device_create_file (dev, &class_device_attr_keyboard);
+	class_device_create_file (dev, &class_device_attr_stats);
+	class_device_create_file (dev, &class_device_attr_vc_stats);
 
 	return 0;
 }
@@ -1006,9 +1006,19 @@ static int vgacon_scroll_region(struct vc_data *c, int t, int b, int dir,
 				int lines)
 {
 	unsigned long oldo;
-	unsigned int delta;
+	unsigned int delta, sr = c->vc_size_row;
+	unsigned int top = t, bottom = c->vc_rows - b;
 
-	if (t || b != c->vc_rows || vga_is_gfx)
+	if (vga_is_gfx)
+		return 0;
+
+	/*
+	 * A region with fixed rows above or below it (status lines) is
+	 * scrolled by moving the origin all the same.  The fixed rows are
+	 * then copied back into place, which beats a memmove of the
+	 * region as long as they are the fewer.
+	 */
+	if ((top || bottom) && top + bottom >= b - t - lines)
 		return 0;
 
 	if (c->vc_origin != c->vc_visible_origin)
@@ -1018,8 +1028,11 @@ static int vgacon_scroll_region(struct vc_data *c, int t, int b, int dir,
 		return 0;
 
 	oldo = c->vc_origin;
-	delta = lines * c->vc_size_row;
+	delta = lines * sr;
 	if (dir == SM_UP) {
+		if (top)
+			scr_memmovew((u16 *) (oldo + delta), (u16 *) oldo,
+				     top * sr);
 		if (c->vc_scr_end + delta >= vga_vram_end) {
 			scr_memcpyw((u16 *) vga_vram_base,
 				    (u16 *) (oldo + delta),
@@ -1032,6 +1045,9 @@ static int vgacon_scroll_region(struct vc_data *c, int t, int b, int dir,
 				     delta), c->vc_video_erase_char,
 			    delta);
 	} else {
+		if (bottom)
+			scr_memmovew((u16 *) (oldo + b * sr - delta),
+				     (u16 *) (oldo + b * sr), bottom * sr);
 		if (oldo - delta < vga_vram_base) {
 			scr_memmovew((u16 *) (vga_vram_end -
 					      c->vc_screenbuf_size +
@@ -1046,6 +1062,18 @@ static int vgacon_scroll_region(struct vc_data *c, int t, int b, int dir,
 			    delta);
 	}
 	c->vc_scr_end = c->vc_origin + c->vc_screenbuf_size;
+	if (dir == SM_UP && bottom) {
+		scr_memmovew((u16 *) (c->vc_origin + b * sr),
+			     (u16 *) (c->vc_origin + b * sr - delta),
+			     bottom * sr);
+		scr_memsetw((u16 *) (c->vc_origin + b * sr - delta),
+			    c->vc_video_erase_char, delta);
+	} else if (dir == SM_DOWN && top) {
+		scr_memmovew((u16 *) c->vc_origin,
+			     (u16 *) (c->vc_origin + delta), top * sr);
+		scr_memsetw((u16 *) (c->vc_origin + t * sr),
+			    c->vc_video_erase_char, delta);
+	}
 	c->vc_visible_origin = c->vc_origin;
 	vga_set_mem_top(c);
 	c->vc_pos = (c->vc_pos - oldo) + c->vc_origin;
@@ -13,3 +13,4 @@ struct vc_data;
 extern unsigned char inverse_translate(struct vc_data *vc, int glyph);
 extern void set_translate(struct vc_data *vc, int m);
 extern int conv_uni_to_pc(struct vc_data *vc, long ucs);
+extern const unsigned short *con_glyph_table(struct vc_data *vc);
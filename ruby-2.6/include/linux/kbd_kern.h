@@ -9,13 +9,28 @@
 
 extern struct tasklet_struct keyboard_tasklet;
 
-extern int shift_state;
-
 extern char *func_table[MAX_NR_FUNC];
 extern char func_buf[];
 extern char *funcbufptr;
 extern int  funcbufsize, funcbufleft;
 
+/*
+ * Keyboard state that follows the keys of one display's keyboard
+ * rather than a VC, so every seat has its own.
+ */
+struct kbd_state {
+	unsigned long key_down[NBITS(KEY_MAX)];	/* keyboard key bitmap */
+	unsigned int keys_down;			/* bits set in key_down */
+	unsigned char shift_down[NR_SHIFT];	/* shift state counters.. */
+	int shift_state;
+	int dead_key_next;
+	int npadch;				/* -1 or number assembled on pad */
+	unsigned char diacr;
+	char rep;				/* flag telling character repeat */
+	int sysrq_down;
+	int sysrq_alt;
+};
+
 #define KBD_DEFMODE	((1 << VC_REPEAT) | (1 << VC_META))
 
 /*
@@ -92,10 +107,7 @@ extern int do_poke_blanked_console;
 
 extern void (*kbd_ledfunc) (unsigned int led);
 
-static inline void set_leds(void)
-{
-	tasklet_schedule(&keyboard_tasklet);
-}
+extern void set_leds(struct vc_data *vc);
 
 static inline int get_kbd_mode(struct kbd_struct * kbd, int flag)
 {
@@ -158,7 +170,10 @@ void kd_mksound(struct input_handle *handle, unsigned int hz, unsigned int ticks
 void kd_nosound(unsigned long private);
 int kbd_rate(struct input_handle *handle, struct kbd_repeat *rep);
 void puts_queue(struct vc_data *vc, char *cp);
-void compute_shiftstate(void);
+struct vt_struct;
+void compute_shiftstate(struct vt_struct *vt);
+void kbd_keymap_changed(int map);
+void kbd_drop_pending(struct vc_data *vc);
 
 /* defkeymap.c */
 
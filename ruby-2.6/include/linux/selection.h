@@ -15,6 +15,8 @@ extern struct vc_data *sel_cons;
 extern void clear_selection(void);
 extern int set_selection(const struct tiocl_selection __user *sel, struct tty_struct *tty);
 extern int paste_selection(struct tty_struct *tty);
+extern void paste_work(void *private);
+extern void paste_cancel(struct vc_data *vc);
 extern int sel_loadlut(char __user *p);
 extern int mouse_reporting(struct vc_data *vc);
 extern void mouse_report(struct vc_data *vc, int butt, int mrx, int mry);
@@ -29,5 +31,6 @@ extern void putconsxy(struct vc_data *vc, unsigned char *p);
 
 extern u16 vcs_scr_readw(struct vc_data *vc, const u16 *org);
 extern void vcs_scr_writew(struct vc_data *vc, u16 val, u16 *org);
+extern void vcs_scr_updated(struct vc_data *vc);
 
 #endif
@@ -110,6 +110,29 @@ extern struct screen_info screen_info;
  */
 #define TTY_FLIPBUF_SIZE 512
 
+/*
+ * Input the line discipline cannot take yet (TTY_DONT_FLIP is set, or
+ * it has no receive room) is moved out of the flip halves into a chain
+ * of these, so the driver can keep filling.  The chain grows up to
+ * TTY_FLIP_MAX_CHUNKS and chunks are freed as soon as they drain.
+ */
+#define TTY_FLIP_MAX_CHUNKS 64
+
+/*
+ * Push to flush latencies are counted in power of two buckets of about
+ * a microsecond (1024ns): bucket 0 holds less than one, bucket n holds
+ * [2^(n-1), 2^n) and the last one everything longer.
+ */
+#define TTY_FLIP_LATENCY_BUCKETS 20
+
+struct tty_flip_chunk {
+	struct tty_flip_chunk *next;
+	int		count;		/* Bytes held */
+	int		read;		/* Bytes already delivered */
+	unsigned char	char_buf[TTY_FLIPBUF_SIZE];
+	char		flag_buf[TTY_FLIPBUF_SIZE];
+};
+
 struct tty_flip_buffer {
 	struct work_struct		work;
 	struct semaphore pty_sem;
@@ -120,6 +143,15 @@ struct tty_flip_buffer {
 	unsigned char	char_buf[2*TTY_FLIPBUF_SIZE];
 	char		flag_buf[2*TTY_FLIPBUF_SIZE];
 	unsigned char	slop[4]; /* N.B. bug overwrites buffer by 1 */
+	struct tty_flip_chunk *head, *tail;	/* Backlog, oldest first */
+	struct tty_flip_chunk *draining;	/* Off the chain, being delivered */
+	int		chunks;
+	unsigned long	dropped;	/* Input bytes lost to overflow */
+	unsigned long	dropped_reported;
+	int		low_latency;	/* Pushes go to the high priority worker */
+	unsigned long long pushed;	/* sched_clock() of the first push not
+					   yet flushed, or 0 */
+	unsigned long	latency[TTY_FLIP_LATENCY_BUCKETS]; /* Push to flush */
 };
 /*
  * The pty uses char_buf and flag_buf as a contiguous buffer
@@ -72,6 +72,19 @@ extern int default_blu[];
  */
 #define NPAR 16
 
+/* Activity counters, shown by the vt sysfs "stats" attributes */
+struct vc_stats {
+	unsigned long bytes;		/* Bytes written to the tty */
+	unsigned long escapes;		/* Escape sequences started */
+	unsigned long putcs;		/* Backend con_putcs() calls */
+	unsigned long cells;		/* Cells drawn by them */
+	unsigned long scrolls;		/* Lines scrolled */
+	unsigned long long write_ns;	/* console_sem held by tty writes, from
+					   acquire_console_sem() to release */
+	unsigned long paste_bytes;	/* Selection bytes pasted */
+	unsigned long long paste_stall_ns; /* Pastes held up by throttling */
+};
+
 struct vc_data {
 	unsigned short vc_num;		/* Console number */
 	unsigned int vc_cols;		/* [#] Console size */
@@ -84,9 +97,20 @@ struct vc_data {
 	unsigned long vc_scr_end;	/* [!] End of real screen */
 	unsigned long vc_visible_origin;/* [!] Top of visible window */
 	unsigned int vc_scrollback;	/* [!] Scrollback size */
+	unsigned short *vc_sb_buf;	/* Scrollback ring, then the saved live screen */
+	unsigned int vc_sb_size;	/* Ring size in lines */
+	unsigned int vc_sb_head;	/* Next ring line to fill */
+	unsigned int vc_sb_count;	/* Lines held in the ring */
+	unsigned int vc_sb_offset;	/* Lines currently scrolled back */
 	unsigned int vc_top, vc_bottom;	/* Scrolling region */
 	unsigned short *vc_screenbuf;	/* In-memory character/attribute buffer */
 	unsigned int vc_screenbuf_size;
+	unsigned short *vc_damage_map;	/* Dirty column span of each row */
+	unsigned int vc_damage_rows;	/* Rows covered by vc_damage_map */
+	unsigned int vc_damage_top;	/* Dirty rows lie within [top, bottom) */
+	unsigned int vc_damage_bottom;
+	unsigned int vc_generation;	/* Bumped by vcs_scr_updated() */
+	struct vc_stats vc_stats;
 	unsigned char vc_attr;		/* Current attributes */
 	unsigned char vc_def_color;	/* Default colors */
 	unsigned char vc_color;		/* Foreground & background */
@@ -161,7 +185,12 @@ struct vc_data {
 	unsigned long vc_uni_pagedir;
 	unsigned long *vc_uni_pagedir_loc;/* [!] Location of uni_pagedir 
 						 variable for this console */
-	wait_queue_head_t paste_wait;	/* For selections */
+	char *vc_paste_buf;		/* Selection text still to be pasted */
+	unsigned int vc_paste_len;
+	unsigned int vc_paste_pos;
+	unsigned long long vc_paste_stall; /* sched_clock() at the stall, or 0 */
+	struct semaphore vc_paste_sem;
+	struct work_struct vc_paste_work;
 	/* Internal flags */
 	unsigned int vc_decscl;		/* operating level */
 	unsigned int vc_c8bit:1;	/* 8-bit controls */
@@ -240,12 +269,16 @@ struct vt_struct {
          * console spinlock. It is shared by with vc_screen read/write tty 
 	 * calls.
          */
-	struct semaphore lock;		/* Lock for con_buf */
+	struct semaphore lock;		/* Lock for con_buf and the display */
+	char vt_locked;			/* lock held through acquire_vt_sem() */
+	unsigned long long vt_locked_at; /* sched_clock() when it took console_sem */
 	char con_buf[BUF_SIZE];
 	const struct consw *vt_sw;	/* Display driver for VT */
 	struct vc_data *default_mode;	/* Default mode */
 	struct work_struct vt_work;	/* VT work queue */
 	struct input_handle *keyboard;  /* Keyboard attached */
+	struct vc_data *kbd_pending;	/* VC with keyboard input not yet pushed */
+	struct kbd_state kbd_state;	/* State of the keys on that keyboard */
 	struct input_handle *beeper;	/* Bell noise support */
 	void *data_hook;		/* Hook for driver data */	
 	unsigned int first_vc;
@@ -254,6 +287,7 @@ struct vt_struct {
         struct list_head node;
         struct proc_dir_entry *procdir;
 	unsigned char vt_ledstate;
+	struct list_head led_node;	/* On the list of VTs with stale LEDs */
 	unsigned char vt_ledioctl;
 	char *display_desc;
 	struct	class_device	dev;		/* Generic device interface */
@@ -271,18 +305,25 @@ void vte_lf(struct vc_data *vc);
 inline void vte_bs(struct vc_data *vc);
 void vte_ed(struct vc_data *vc, int vpar);
 void vte_decsc(struct vc_data *vc);
-void terminal_emulation(struct tty_struct *tty, int c);
+void terminal_emulation(struct vc_data *vc, int c);
 
 /* vt.c */
 /* Some debug stub to catch some of the obvious races in the VT code */
 #if 1
 #define WARN_CONSOLE_UNLOCKED() WARN_ON(!is_console_locked() && !oops_in_progress)
+#define WARN_VT_UNLOCKED(vt) \
+	WARN_ON(!is_console_locked() && !(vt)->vt_locked && !oops_in_progress)
 #else
 #define WARN_CONSOLE_UNLOCKED()
+#define WARN_VT_UNLOCKED(vt)
 #endif
 
+void acquire_vt_sem(struct vt_struct *vt);
+void release_vt_sem(struct vt_struct *vt);
+
 const char *vt_map_display(struct vt_struct *vt, int init, int vc_count);
 void vt_map_input(struct vt_struct *vt);
+struct vt_struct *find_vt(int currcons);
 struct vc_data *find_vc(int currcons);
 struct vc_data *vc_allocate(unsigned int console);
 inline void set_console(struct vc_data *vc);
@@ -300,6 +341,7 @@ void scroll_up(struct vc_data *vc, int);
 void scroll_down(struct vc_data *vc, int);
 void scroll_region_up(struct vc_data *vc, unsigned int t, unsigned int b, int nr);
 void scroll_region_down(struct vc_data *vc, unsigned int t, unsigned int b, int nr); 
+void vc_sb_reset(struct vc_data *vc);
 void default_attr(struct vc_data *vc);
 void update_attr(struct vc_data *vc);
 void insert_char(struct vc_data *vc, unsigned int nr);
@@ -307,7 +349,9 @@ void delete_char(struct vc_data *vc, unsigned int nr);
 void insert_line(struct vc_data *vc, unsigned int nr);
 void delete_line(struct vc_data *vc, unsigned int nr);
 void set_origin(struct vc_data *vc);
-inline void clear_region(struct vc_data *vc, int x, int y, int width, int height);
+void vc_damage(struct vc_data *vc, unsigned int y, unsigned int x, unsigned int width);
+void vc_damage_lines(struct vc_data *vc, unsigned int top, unsigned int bottom);
+void vc_flush_damage(struct vc_data *vc);
 void do_update_region(struct vc_data *vc, unsigned long start, int count);
 void update_region(struct vc_data *vc, unsigned long start, int count);
 void update_screen(struct vc_data *vc);
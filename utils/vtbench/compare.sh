@@ -0,0 +1,79 @@
+#!/bin/sh
+#
+# compare.sh - vtbench on two kernel trees, runs interleaved
+#
+# usage: compare.sh [-c COLUMN] OLD_KSRC NEW_KSRC [ROUNDS] [vtbench options and corpora]
+#
+# Each tree gets its own build of the harness.  The two are run in
+# turn ROUNDS times (default 9), so that a noisy machine slows both
+# alike, and the median MB/s of every corpus is reported.  -c picks
+# another column of the vtbench output by its heading, e.g. "-c cells/B"
+# for the cells drawn per byte, which does not need more than one
+# round.  The KSRC
+# directories are the ruby-2.6 directories of two checkouts, e.g. of
+# git worktrees of the commits to compare.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+
+set -e
+
+column=MB/s
+if [ "$1" = -c ]; then
+	column=$2
+	shift 2
+fi
+if [ $# -lt 2 ]; then
+	echo "usage: $0 [-c COLUMN] OLD_KSRC NEW_KSRC [ROUNDS] [vtbench options and corpora]" >&2
+	exit 2
+fi
+old=$(cd "$1" && pwd)
+new=$(cd "$2" && pwd)
+shift 2
+rounds=9
+case "$1" in
+[0-9]*)	rounds=$1; shift ;;
+esac
+
+src=$(cd "$(dirname "$0")" && pwd)
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+for t in old new; do
+	mkdir "$tmp/$t"
+	cp -r "$src"/Makefile "$src"/*.c "$src"/*.h "$src"/stubs "$tmp/$t"
+	eval ksrc=\$$t
+	if ! make -s -C "$tmp/$t" KSRC="$ksrc" vtbench >"$tmp/$t.log" 2>&1; then
+		cat "$tmp/$t.log" >&2
+		exit 1
+	fi
+done
+
+i=0
+while [ $i -lt "$rounds" ]; do
+	for t in old new; do
+		"$tmp/$t/vtbench" "$@" | awk -v t=$t -v column="$column" '
+			NR == 1 { for (i = 1; i <= NF; i++) if ($i == column) c = i; next }
+			c { print t, $1, $c }'
+	done
+	i=$((i + 1))
+done > "$tmp/runs"
+
+# Median per tree and corpus
+if [ ! -s "$tmp/runs" ]; then
+	echo "$0: no column $column in the vtbench output" >&2
+	exit 1
+fi
+sort -k1,1 -k2,2 -k3,3n "$tmp/runs" | awk -v column="$column" '
+	{ v[$1 " " $2, ++n[$1 " " $2]] = $3; seen[$2] = 1 }
+	END {
+		printf "%-10s %10s %10s %8s\n", "corpus", "old " column, "new " column, "new/old"
+		for (c in seen) {
+			o = v["old " c, int((n["old " c] + 1) / 2)]
+			w = v["new " c, int((n["new " c] + 1) / 2)]
+			printf "%-10s %10.3f %10.3f %8.2f\n", c, o, w, o ? w / o : 0
+		}
+	}'
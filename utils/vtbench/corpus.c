@@ -0,0 +1,267 @@
+/*
+ * corpus.c - the built-in terminal output the benchmarks replay.
+ *
+ * Each generator appends one "unit" (a few log lines, a screenful, an
+ * editing burst) sized for the given geometry; corpus_make() repeats
+ * it until the corpus is big enough.  The generators are seeded, so a
+ * corpus is the same from run to run and from tree to tree.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "corpus.h"
+
+static const char *words[] = {
+	"kernel:", "usb", "1-1:", "new", "high-speed", "device", "number", "3",
+	"using", "ehci_hcd", "eth0:", "link", "up,", "1000Mbps,", "full-duplex",
+	"EXT3-fs:", "mounted", "filesystem", "with", "ordered", "data", "mode.",
+	"sshd[2143]:", "Accepted", "publickey", "for", "root", "from", "port",
+	"CRON[881]:", "(root)", "CMD", "(run-parts", "/etc/cron.hourly)",
+	"input:", "AT", "Translated", "Set", "2", "keyboard", "as", "serio0",
+};
+
+/* The same LCG everywhere, so corpora do not depend on the libc */
+unsigned long corpus_rand(struct corpus_buf *b)
+{
+	b->seed = b->seed * 1103515245 + 12345;
+	return (b->seed >> 16) & 0x7fff;
+}
+
+static void put(struct corpus_buf *b, const void *s, size_t len)
+{
+	if (b->len + len > b->size) {
+		b->size = (b->len + len) * 2;
+		b->data = realloc(b->data, b->size);
+		if (!b->data) {
+			perror("corpus");
+			exit(1);
+		}
+	}
+	memcpy(b->data + b->len, s, len);
+	b->len += len;
+}
+
+static void puts_(struct corpus_buf *b, const char *s)
+{
+	put(b, s, strlen(s));
+}
+
+static void printf_(struct corpus_buf *b, const char *fmt, ...)
+{
+	char tmp[256];
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+	va_end(ap);
+	put(b, tmp, n < (int) sizeof(tmp) ? n : (int) sizeof(tmp) - 1);
+}
+
+static void words_(struct corpus_buf *b, int len)
+{
+	int n = 0;
+
+	while (n < len) {
+		const char *w = words[corpus_rand(b) % (sizeof(words) / sizeof(*words))];
+
+		if (n)
+			puts_(b, " ");
+		puts_(b, w);
+		n += strlen(w) + 1;
+	}
+}
+
+/* dmesg or syslog scrolling by: plain ASCII, CR LF */
+static void gen_plain(struct corpus_buf *b, int cols, int rows)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		printf_(b, "[%5lu.%06lu] ", corpus_rand(b), corpus_rand(b) * 31);
+		words_(b, corpus_rand(b) % (cols - 10));
+		puts_(b, "\r\n");
+	}
+}
+
+/* The same in a UTF-8 locale: accented Latin, Greek and box drawing */
+static void gen_utf8(struct corpus_buf *b, int cols, int rows)
+{
+	static const char *utf8_words[] = {
+		"caf\xc3\xa9", "\xc3\xbc" "ber", "ma\xc3\xb1" "ana", "Stra\xc3\x9f" "e",
+		"\xc3\xa4rger", "gr\xc3\xb6\xc3\x9f" "er", "\xce\xb1\xce\xb2",
+		"\xce\xa3=\xcf\x80", "\xe2\x94\x80\xe2\x94\x80\xe2\x94\x80",
+		"\xe2\x94\x82", "\xe2\x96\x91\xe2\x96\x92\xe2\x96\x93",
+		"21\xc2\xb0" "C", "\xc2\xb1" "5%", "m\xc2\xb2",
+	};
+	int i, n;
+
+	for (i = 0; i < 8; i++) {
+		printf_(b, "[%5lu.%06lu] ", corpus_rand(b), corpus_rand(b) * 31);
+		for (n = 0; n < (int) (corpus_rand(b) % (cols - 20)); n += 8) {
+			if (corpus_rand(b) & 1)
+				puts_(b, utf8_words[corpus_rand(b) %
+					     (sizeof(utf8_words) / sizeof(*utf8_words))]);
+			else
+				words_(b, 1);
+			puts_(b, " ");
+		}
+		puts_(b, "\r\n");
+	}
+}
+
+/* ls --color: a colour change every few characters */
+static void gen_sgr(struct corpus_buf *b, int cols, int rows)
+{
+	static const char *colors[] = {
+		"01;34", "01;32", "01;36", "40;33;01", "01;31", "00", "01;35", "30;42",
+	};
+	int i, x;
+
+	for (i = 0; i < 4; i++) {
+		for (x = 0; x + 16 <= cols; x += 16) {
+			unsigned long r = corpus_rand(b);
+
+			printf_(b, "\033[0m\033[%sm%-12.12s\033[0m  ", colors[r % 8],
+				words[r % (sizeof(words) / sizeof(*words))]);
+			puts_(b, "  ");
+		}
+		puts_(b, "\r\n");
+	}
+}
+
+/* top, htop: the whole screen redrawn in place, field by field */
+static void gen_tui(struct corpus_buf *b, int cols, int rows)
+{
+	int y;
+
+	printf_(b, "\033[H\033[7m top - %02lu:%02lu:%02lu up 3 days, load average: 0.%02lu\033[K\033[m",
+		corpus_rand(b) % 24, corpus_rand(b) % 60, corpus_rand(b) % 60,
+		corpus_rand(b) % 100);
+	for (y = 2; y <= rows; y++) {
+		unsigned long r = corpus_rand(b);
+
+		printf_(b, "\033[%d;1H\033[%sm%5lu\033[m root      20   0 %7lu %6lu S %4.1f",
+			y, (r & 3) ? "0" : "1", r, r * 7, r % 9000,
+			(double) (r % 1000) / 10);
+		printf_(b, " \033[3%dm%-16.16s\033[m\033[K", (int) (r % 7) + 1,
+			words[r % (sizeof(words) / sizeof(*words))]);
+	}
+}
+
+/* An editor: scroll regions, inserted and deleted lines and characters */
+static void gen_edit(struct corpus_buf *b, int cols, int rows)
+{
+	int i, y = 2 + corpus_rand(b) % (rows - 3);
+
+	printf_(b, "\033[1;%dr", rows - 1);
+	for (i = 0; i < 6; i++) {
+		unsigned long r = corpus_rand(b);
+
+		printf_(b, "\033[%d;%dH", y, 1 + (int) (r % (cols / 2)));
+		switch (r % 6) {
+		case 0:		/* open a line */
+			printf_(b, "\033[L");
+			words_(b, r % (cols - 10));
+			break;
+		case 1:		/* dd */
+			printf_(b, "\033[%dM", 1 + (int) (r % 3));
+			break;
+		case 2:		/* insert some text */
+			printf_(b, "\033[%d@", 4 + (int) (r % 8));
+			words_(b, 4);
+			break;
+		case 3:		/* x x x */
+			printf_(b, "\033[%dP", 1 + (int) (r % 6));
+			break;
+		case 4:		/* scroll the text up a line, as ^E does */
+			printf_(b, "\033[%d;1H\n", rows - 1);
+			words_(b, r % (cols - 10));
+			break;
+		case 5:		/* ... and down, as ^Y does */
+			printf_(b, "\033[1;1H\033M");
+			words_(b, r % (cols - 10));
+			break;
+		}
+	}
+	printf_(b, "\033[r\033[%d;1H\033[7m-- INSERT --\033[m\033[K", rows);
+}
+
+/*
+ * Escape sequences and nothing else, all of them cheap to carry out:
+ * attributes with several parameters, absolute and relative cursor
+ * moves, save and restore, modes.  Next to no cell is drawn, so the
+ * time goes into the parser.
+ */
+static void gen_parse(struct corpus_buf *b, int cols, int rows)
+{
+	int i;
+
+	for (i = 0; i < 16; i++) {
+		unsigned long r = corpus_rand(b);
+
+		printf_(b, "\033[%d;%dH", 1 + (int) (r % rows),
+			1 + (int) ((r >> 8) % cols));
+		printf_(b, "\033[0;%d;%d;%dm", 30 + (int) (r % 8),
+			40 + (int) ((r >> 3) % 8), (r & 64) ? 1 : 22);
+		printf_(b, "\0337\033[%dA\033[%dC\0338", 1 + (int) (r % 3),
+			1 + (int) ((r >> 2) % 5));
+		printf_(b, "\033[?25%c\033[4%c\033[m", (r & 128) ? 'h' : 'l',
+			(r & 256) ? 'h' : 'l');
+	}
+	puts_(b, "\033[?25h\033[4l");
+}
+
+const struct corpus corpora[] = {
+	{ "plain", "log lines, ASCII only", 0, gen_plain },
+	{ "utf8", "log lines with UTF-8", 1, gen_utf8 },
+	{ "sgr", "ls --color, escape-heavy", 0, gen_sgr },
+	{ "tui", "full screen redraws", 0, gen_tui },
+	{ "edit", "scroll regions, IL/DL/ICH/DCH", 0, gen_edit },
+	{ "parse", "escape sequences only, no text", 0, gen_parse },
+	{ NULL }
+};
+
+const struct corpus *corpus_find(const char *name)
+{
+	const struct corpus *c;
+
+	for (c = corpora; c->name; c++)
+		if (!strcmp(c->name, name))
+			return c;
+	return NULL;
+}
+
+/* At least size bytes of whole units, from a fixed seed */
+int corpus_make(struct corpus_buf *b, const struct corpus *c, size_t size,
+		int cols, int rows)
+{
+	b->len = 0;
+	b->seed = 1;
+	while (b->len < size)
+		c->gen(b, cols, rows);
+	return 0;
+}
+
+int corpus_load(struct corpus_buf *b, const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	char tmp[65536];
+	size_t n;
+
+	if (!f)
+		return -1;
+	b->len = 0;
+	while ((n = fread(tmp, 1, sizeof(tmp), f)) > 0)
+		put(b, tmp, n);
+	fclose(f);
+	return 0;
+}
@@ -0,0 +1,36 @@
+/*
+ * corpus.h - the built-in terminal output the benchmarks replay.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef _CORPUS_H
+#define _CORPUS_H
+
+#include <stddef.h>
+
+struct corpus_buf {
+	unsigned char *data;
+	size_t len, size;
+	unsigned long seed;
+};
+
+struct corpus {
+	const char *name;
+	const char *desc;
+	int utf8;		/* Meant for a console in UTF-8 mode */
+	void (*gen)(struct corpus_buf *b, int cols, int rows);
+};
+
+extern const struct corpus corpora[];
+
+extern const struct corpus *corpus_find(const char *name);
+extern int corpus_make(struct corpus_buf *b, const struct corpus *c,
+		       size_t size, int cols, int rows);
+extern int corpus_load(struct corpus_buf *b, const char *path);
+extern unsigned long corpus_rand(struct corpus_buf *b);
+
+#endif
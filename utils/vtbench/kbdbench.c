@@ -0,0 +1,257 @@
+/*
+ * kbdbench.c - feed key events through keyboard.c and report what a key
+ * costs: the time kbd_event() and kbd_keycode() take, and what they
+ * leave to others, i.e. flip buffer flushes and LED updates.
+ *
+ * The program stands in for the input core and a PC keyboard.  Every
+ * press and release is a report of its own, an EV_KEY event followed
+ * by EV_SYN, and the keyboard tasklet and the console work run after
+ * each report, as they would once the interrupt is done.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <getopt.h>
+
+#include <linux/tty.h>
+#include <linux/vt_kern.h>
+
+#include "recordcon.h"
+#include "kbdmap.h"
+
+static const char sample[] =
+	"The quick brown fox jumps over the lazy dog; THE QUICK BROWN FOX\n"
+	"jumps over 13 lazy dogs, (twice) & [then] some: \"quoted\" <text>?\n";
+
+struct key {
+	unsigned short code;
+	char down;
+};
+
+static struct key *keys;
+static int nr_keys;
+
+/* The corpora: what is typed, and how */
+static const struct kbd_corpus {
+	const char *name;
+	const char *desc;
+	int caps;		/* capitals through CapsLock, not Shift */
+	int cursor;		/* arrow keys and backspace between words */
+} corpora[] = {
+	{ "text",   "typing with Shift for the capitals", 0, 0 },
+	{ "caps",   "capitals typed with CapsLock on", 1, 0 },
+	{ "cursor", "arrow keys and backspace between the words", 0, 1 },
+	{ NULL }
+};
+
+static void add_key(int code, int down)
+{
+	static int size;
+
+	if (nr_keys == size) {
+		size = size ? 2 * size : 4096;
+		keys = realloc(keys, size * sizeof(*keys));
+		if (!keys) {
+			perror("kbdbench");
+			exit(1);
+		}
+	}
+	keys[nr_keys].code = code;
+	keys[nr_keys].down = down;
+	nr_keys++;
+}
+
+static void tap(int code)
+{
+	add_key(code, 1);
+	add_key(code, 0);
+}
+
+static void make_keys(const struct kbd_corpus *c, int count)
+{
+	int i = 0, shift, code, caps = 0, upper;
+
+	nr_keys = 0;
+	while (nr_keys < count) {
+		unsigned char ch = sample[i++ % (sizeof(sample) - 1)];
+
+		if ((code = kbdmap_key(ch, &shift)) < 0)
+			continue;
+		upper = ch >= 'A' && ch <= 'Z';
+		if (c->caps && ch != ' ' && upper != caps) {
+			tap(KEY_CAPSLOCK);
+			caps = upper;
+		}
+		if (c->caps && upper)
+			shift = 0;
+		if (c->cursor && ch == ' ') {
+			tap(KEY_LEFT);
+			tap(KEY_RIGHT);
+			tap(KEY_BACKSPACE);
+		}
+		if (shift)
+			add_key(KEY_LEFTSHIFT, 1);
+		tap(code);
+		if (shift)
+			add_key(KEY_LEFTSHIFT, 0);
+	}
+	if (caps)
+		tap(KEY_CAPSLOCK);
+}
+
+/*
+ * The input core, as far as keyboard.c binds to it.  input_event() is
+ * what the driver sends to the device: LEDs and sounds.
+ */
+static struct input_handler *handler;
+static unsigned long led_events;
+
+void input_register_handler(struct input_handler *h)
+{
+	handler = h;
+}
+
+void input_unregister_handler(struct input_handler *h)
+{
+	handler = NULL;
+}
+
+int input_open_device(struct input_handle *handle)
+{
+	handle->open++;
+	return 0;
+}
+
+void input_close_device(struct input_handle *handle)
+{
+	handle->open--;
+}
+
+void input_event(struct input_dev *dev, unsigned int type, unsigned int code,
+		 int value)
+{
+	if (type == EV_LED)
+		led_events++;
+}
+
+/* The end of the keyboard interrupt: the tasklet, then the work */
+static void irq_exit(void)
+{
+	if (keyboard_tasklet.scheduled && !keyboard_tasklet.disabled) {
+		keyboard_tasklet.scheduled = 0;
+		keyboard_tasklet.func(keyboard_tasklet.data);
+	}
+	run_scheduled_work();
+}
+
+static void type_keys(struct input_handle *handle)
+{
+	int i;
+
+	for (i = 0; i < nr_keys; i++) {
+		handler->event(handle, EV_KEY, keys[i].code, keys[i].down);
+		handler->event(handle, EV_SYN, SYN_REPORT, 0);
+		irq_exit();
+	}
+}
+
+static void usage(void)
+{
+	const struct kbd_corpus *c;
+
+	fprintf(stderr,
+		"usage: kbdbench [options] [corpus]...\n"
+		"  -n KEYS       key events per corpus (1M)\n"
+		"  -r RUNS       runs per corpus, best one reported (5)\n"
+		"corpora:\n");
+	for (c = corpora; c->name; c++)
+		fprintf(stderr, "  %-8s %s\n", c->name, c->desc);
+	exit(2);
+}
+
+static void run(const struct kbd_corpus *c, struct input_handle *handle,
+		int count, int runs)
+{
+	unsigned long long best = ~0ULL, t;
+	unsigned long flushes = 0, bytes = 0, leds = 0;
+	int r;
+
+	make_keys(c, count);
+	for (r = 0; r < runs; r++) {
+		kstub_flip_flushes = kstub_flip_bytes = led_events = 0;
+		t = sched_clock();
+		type_keys(handle);
+		t = sched_clock() - t;
+		if (t < best) {
+			best = t;
+			flushes = kstub_flip_flushes;
+			bytes = kstub_flip_bytes;
+			leds = led_events;
+		}
+	}
+	printf("%-10s %9d %8.1f %8.2f %8.4f %8.4f %8.4f\n", c->name, nr_keys,
+	       (double) best / nr_keys, nr_keys / (best / 1e3),
+	       (double) flushes / nr_keys, (double) bytes / nr_keys,
+	       (double) leds / nr_keys);
+}
+
+int main(int argc, char **argv)
+{
+	const struct kbd_corpus *c;
+	struct rec_display *disp;
+	struct input_handle *handle;
+	static struct input_dev dev = { .name = "kbdbench keyboard" };
+	int count = 1 << 20, runs = 5, i, opt;
+
+	while ((opt = getopt(argc, argv, "n:r:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 'r':
+			runs = atoi(optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (count < 1 || runs < 1)
+		usage();
+
+	kbdmap_init();
+	disp = rec_add_display(&rec_con, 80, 25, 1);
+	if (!disp || rec_start() || !rec_open(disp->vt.first_vc) || !handler) {
+		fprintf(stderr, "kbdbench: cannot set up the console\n");
+		return 1;
+	}
+	set_bit(EV_KEY, dev.evbit);
+	set_bit(EV_LED, dev.evbit);
+	set_bit(EV_SYN, dev.evbit);
+	for (i = KEY_ESC; i < BTN_MISC; i++)
+		set_bit(i, dev.keybit);
+	handle = handler->connect(handler, &dev, NULL);
+	if (!handle || handle->private != &disp->vt) {
+		fprintf(stderr, "kbdbench: the keyboard did not bind to the display\n");
+		return 1;
+	}
+
+	printf("%-10s %9s %8s %8s %8s %8s %8s\n", "corpus", "events",
+	       "ns/ev", "Mev/s", "flush/ev", "bytes/ev", "leds/ev");
+	if (optind == argc)
+		for (c = corpora; c->name; c++)
+			run(c, handle, count, runs);
+	for (i = optind; i < argc; i++) {
+		for (c = corpora; c->name; c++)
+			if (!strcmp(argv[i], c->name))
+				break;
+		if (!c->name)
+			usage();
+		run(c, handle, count, runs);
+	}
+	if (kstub_warnings)
+		fprintf(stderr, "kbdbench: %lu warnings\n", kstub_warnings);
+	return kstub_warnings != 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * kbdmap.c - the keymap tables keyboard.c expects from defkeymap.c:
+ * a US layout for the plain, Shift, Ctrl and Alt maps, the strings of
+ * F1-F4 and an empty accent table.  kbdmap_init() has to fill the maps
+ * in before vty_init() compiles them; kbdmap_key() goes the other way,
+ * from a character to the key that types it.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <linux/kbd_kern.h>
+#include <linux/kbd_diacr.h>
+
+#include "kbdmap.h"
+
+#define KS(k)		(0xf000 | (k))
+
+unsigned short plain_map[NR_KEYS], shift_map[NR_KEYS];
+unsigned short ctrl_map[NR_KEYS], alt_map[NR_KEYS];
+
+unsigned short *key_maps[MAX_NR_KEYMAPS] = {
+	[0]				= plain_map,
+	[1 << KG_SHIFT]			= shift_map,
+	[1 << KG_CTRL]			= ctrl_map,
+	[1 << KG_ALT]			= alt_map,
+};
+unsigned int keymap_count = 4;
+
+char func_buf[] = "\033[[A\0\033[[B\0\033[[C\0\033[[D\0";
+char *funcbufptr = func_buf;
+int funcbufsize = sizeof(func_buf);
+int funcbufleft = 0;
+char *func_table[MAX_NR_FUNC] = {
+	func_buf, func_buf + 5, func_buf + 10, func_buf + 15,
+};
+
+struct kbdiacr accent_table[MAX_DIACR];
+unsigned int accent_table_size;
+
+/* The rows of the main block, each on consecutive keycodes */
+static const struct {
+	int first;
+	const char *plain, *shift;
+} rows[] = {
+	{ KEY_1,	 "1234567890-=",	"!@#$%^&*()_+" },
+	{ KEY_Q,	 "qwertyuiop[]",	"QWERTYUIOP{}" },
+	{ KEY_A,	 "asdfghjkl;'`",	"ASDFGHJKL:\"~" },
+	{ KEY_BACKSLASH, "\\",			"|" },
+	{ KEY_Z,	 "zxcvbnm,./",		"ZXCVBNM<>?" },
+};
+
+/* Keys that are the same in every map */
+static const struct {
+	int code;
+	unsigned short sym;
+} common[] = {
+	{ KEY_ESC,		KS(K(KT_LATIN, 0x1b)) },
+	{ KEY_BACKSPACE,	KS(K(KT_LATIN, 0x7f)) },
+	{ KEY_TAB,		KS(K(KT_LATIN, '\t')) },
+	{ KEY_SPACE,		KS(K(KT_LATIN, ' ')) },
+	{ KEY_ENTER,		KS(K_ENTER) },
+	{ KEY_LEFTSHIFT,	KS(K_SHIFT) },
+	{ KEY_RIGHTSHIFT,	KS(K_SHIFT) },
+	{ KEY_LEFTCTRL,		KS(K_CTRL) },
+	{ KEY_LEFTALT,		KS(K_ALT) },
+	{ KEY_CAPSLOCK,		KS(K_CAPS) },
+	{ KEY_NUMLOCK,		KS(K_NUM) },
+	{ KEY_F1,		KS(K_F1) },
+	{ KEY_F2,		KS(K_F2) },
+	{ KEY_F3,		KS(K_F3) },
+	{ KEY_F4,		KS(K_F4) },
+	{ KEY_UP,		KS(K_UP) },
+	{ KEY_DOWN,		KS(K_DOWN) },
+	{ KEY_LEFT,		KS(K_LEFT) },
+	{ KEY_RIGHT,		KS(K_RIGHT) },
+};
+
+/* The key that types c, and whether it takes Shift; -1 if none does */
+int kbdmap_key(unsigned char c, int *shift)
+{
+	const char *p;
+	int i;
+
+	*shift = 0;
+	if (c == ' ')
+		return KEY_SPACE;
+	if (c == '\n')
+		return KEY_ENTER;
+	if (!c)
+		return -1;
+	for (i = 0; i < ARRAY_SIZE(rows); i++) {
+		if ((p = strchr(rows[i].plain, c)))
+			return rows[i].first + (p - rows[i].plain);
+		if ((p = strchr(rows[i].shift, c))) {
+			*shift = 1;
+			return rows[i].first + (p - rows[i].shift);
+		}
+	}
+	return -1;
+}
+
+static unsigned short latin(unsigned char c)
+{
+	if ((c | 0x20) >= 'a' && (c | 0x20) <= 'z')
+		return KS(K(KT_LETTER, c));
+	return KS(K(KT_LATIN, c));
+}
+
+void kbdmap_init(void)
+{
+	int i, j, code;
+
+	for (i = 0; i < NR_KEYS; i++)
+		plain_map[i] = shift_map[i] = ctrl_map[i] = alt_map[i] = KS(K_HOLE);
+
+	for (i = 0; i < ARRAY_SIZE(rows); i++) {
+		for (j = 0; rows[i].plain[j]; j++) {
+			unsigned char c = rows[i].plain[j];
+
+			code = rows[i].first + j;
+			plain_map[code] = latin(c);
+			shift_map[code] = latin(rows[i].shift[j]);
+			if (c >= 'a' && c <= 'z')
+				ctrl_map[code] = KS(K(KT_LATIN, c & 0x1f));
+			alt_map[code] = KS(K(KT_META, c));
+		}
+	}
+	for (i = 0; i < ARRAY_SIZE(common); i++) {
+		code = common[i].code;
+		plain_map[code] = shift_map[code] = common[i].sym;
+		ctrl_map[code] = alt_map[code] = common[i].sym;
+	}
+}
@@ -0,0 +1,17 @@
+/*
+ * kbdmap.h - the keymap tables kbdmap.c provides in place of
+ * defkeymap.c.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef _KBDMAP_H
+#define _KBDMAP_H
+
+extern void kbdmap_init(void);
+extern int kbdmap_key(unsigned char c, int *shift);
+
+#endif
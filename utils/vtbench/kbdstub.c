@@ -0,0 +1,51 @@
+/*
+ * kbdstub.c - stand-ins for the keyboard driver, for the programs that
+ * do not link keyboard.c.
+ *
+ * <linux/kbd_kern.h> is left out on purpose: some of these prototypes
+ * have changed over time, and the stubs do nothing with their arguments,
+ * so they link against older trees as well.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <kstub.h>
+
+struct vc_data;
+struct input_handle;
+
+struct tasklet_struct keyboard_tasklet;
+int shift_state;		/* a global before keyboard state went per VT */
+
+int kbd_init(void)
+{
+	return 0;
+}
+
+void setledstate(struct vc_data *vc, unsigned int led)
+{
+}
+
+void set_leds(struct vc_data *vc)
+{
+}
+
+void kd_mksound(struct input_handle *handle, unsigned int hz, unsigned int ticks)
+{
+}
+
+void kd_nosound(unsigned long private)
+{
+}
+
+/* Terminal replies (DSR, DA) are dropped */
+void puts_queue(struct vc_data *vc, char *cp)
+{
+}
+
+void kbd_drop_pending(struct vc_data *vc)
+{
+}
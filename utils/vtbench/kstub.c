@@ -0,0 +1,427 @@
+/*
+ * kstub.c - the kernel services the console code calls, implemented
+ * on top of libc and pthreads.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <stdarg.h>
+#include <sched.h>
+#include <time.h>
+
+#include <kstub.h>
+#include <linux/tty.h>
+#include <linux/console.h>
+
+/*
+ * Messages
+ */
+int printk(const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	if (fmt[0] == '<' && fmt[1] && fmt[2] == '>')
+		fmt += 3;
+	va_start(ap, fmt);
+	n = vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	return n;
+}
+
+void panic(const char *fmt, ...)
+{
+	va_list ap;
+
+	fputs("panic: ", stderr);
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+	abort();
+}
+
+unsigned long kstub_warnings;
+int oops_in_progress;
+
+void kstub_warn(const char *file, int line)
+{
+	__sync_add_and_fetch(&kstub_warnings, 1);
+	fprintf(stderr, "WARNING at %s:%d\n", file, line);
+}
+
+/*
+ * Bitmaps
+ */
+int find_next_bit(const unsigned long *addr, int size, int offset)
+{
+	for (; offset < size; offset++)
+		if (test_bit(offset, addr))
+			return offset;
+	return size;
+}
+
+/*
+ * Memory
+ */
+void *kmalloc(size_t size, int flags)
+{
+	return malloc(size ? size : 1);
+}
+
+void kfree(const void *p)
+{
+	free((void *) p);
+}
+
+void *vmalloc(unsigned long size)
+{
+	return malloc(size ? size : 1);
+}
+
+void vfree(void *p)
+{
+	free(p);
+}
+
+void *alloc_bootmem(unsigned long size)
+{
+	return calloc(1, size);
+}
+
+void free_bootmem(unsigned long addr, unsigned long size)
+{
+	free((void *) addr);
+}
+
+/*
+ * Time and tasks
+ */
+volatile unsigned long jiffies = 300 * HZ;
+
+unsigned long long sched_clock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static struct signal_struct init_signal;
+static struct task_struct init_task = { 1, &init_signal };
+struct task_struct *current = &init_task;
+
+void schedule(void)
+{
+	sched_yield();
+}
+
+int cond_resched(void)
+{
+	sched_yield();
+	return 0;
+}
+
+int kill_pg(int pgrp, int sig, int priv)
+{
+	return 0;
+}
+
+int kill_proc(int pid, int sig, int priv)
+{
+	return 0;
+}
+
+/*
+ * Semaphores
+ */
+void sema_init(struct semaphore *sem, int val)
+{
+	sem->count = val;
+	pthread_mutex_init(&sem->mutex, NULL);
+	pthread_cond_init(&sem->wait, NULL);
+}
+
+void down(struct semaphore *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	while (sem->count <= 0)
+		pthread_cond_wait(&sem->wait, &sem->mutex);
+	sem->count--;
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+int down_interruptible(struct semaphore *sem)
+{
+	down(sem);
+	return 0;
+}
+
+int down_trylock(struct semaphore *sem)
+{
+	int busy;
+
+	pthread_mutex_lock(&sem->mutex);
+	busy = sem->count <= 0;
+	if (!busy)
+		sem->count--;
+	pthread_mutex_unlock(&sem->mutex);
+	return busy;
+}
+
+void up(struct semaphore *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	sem->count++;
+	pthread_cond_signal(&sem->wait);
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+/*
+ * Deferred work, run on demand in the order it was queued
+ */
+static pthread_mutex_t work_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct work_struct *work_head, **work_tail = &work_head;
+
+int schedule_work(struct work_struct *work)
+{
+	int queued = 0;
+
+	pthread_mutex_lock(&work_lock);
+	if (!work->pending) {
+		work->pending = 1;
+		work->next = NULL;
+		*work_tail = work;
+		work_tail = &work->next;
+		queued = 1;
+	}
+	pthread_mutex_unlock(&work_lock);
+	return queued;
+}
+
+int schedule_delayed_work(struct work_struct *work, unsigned long delay)
+{
+	return schedule_work(work);
+}
+
+int cancel_delayed_work(struct work_struct *work)
+{
+	struct work_struct **pp;
+	int found = 0;
+
+	pthread_mutex_lock(&work_lock);
+	for (pp = &work_head; *pp; pp = &(*pp)->next) {
+		if (*pp == work) {
+			*pp = work->next;
+			if (!*pp)
+				work_tail = pp;
+			work->pending = 0;
+			found = 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&work_lock);
+	return found;
+}
+
+/* Returns the number of items run; work queued meanwhile runs too */
+int run_scheduled_work(void)
+{
+	struct work_struct *work;
+	int n = 0;
+
+	for (;;) {
+		pthread_mutex_lock(&work_lock);
+		work = work_head;
+		if (work) {
+			work_head = work->next;
+			if (!work_head)
+				work_tail = &work_head;
+			work->pending = 0;
+		}
+		pthread_mutex_unlock(&work_lock);
+		if (!work)
+			return n;
+		work->func(work->data);
+		n++;
+	}
+}
+
+void flush_scheduled_work(void)
+{
+	run_scheduled_work();
+}
+
+/*
+ * The console lock.  The time spent waiting for it is what the
+ * contention benchmark reports.
+ */
+static DECLARE_MUTEX(console_sem);
+static int console_locked;
+unsigned long long kstub_console_wait_ns;
+
+void acquire_console_sem(void)
+{
+	unsigned long long t = sched_clock();
+
+	down(&console_sem);
+	__sync_add_and_fetch(&kstub_console_wait_ns, sched_clock() - t);
+	console_locked = 1;
+}
+
+int try_acquire_console_sem(void)
+{
+	if (down_trylock(&console_sem))
+		return -1;
+	console_locked = 1;
+	return 0;
+}
+
+void release_console_sem(void)
+{
+	console_locked = 0;
+	up(&console_sem);
+}
+
+int is_console_locked(void)
+{
+	return console_locked;
+}
+
+void console_conditional_schedule(void)
+{
+}
+
+/* printk() goes to stderr; the VT console driver is never called */
+void register_console(struct console *console)
+{
+}
+
+/*
+ * The tty layer, as far as a tty driver sees it
+ */
+DECLARE_MUTEX(tty_sem);
+struct termios tty_std_termios;
+
+struct tty_driver *alloc_tty_driver(int lines)
+{
+	struct tty_driver *driver = calloc(1, sizeof(*driver));
+
+	if (driver)
+		driver->num = lines;
+	return driver;
+}
+
+void put_tty_driver(struct tty_driver *driver)
+{
+	free(driver);
+}
+
+void tty_set_operations(struct tty_driver *driver, struct tty_operations *op)
+{
+	driver->open = op->open;
+	driver->close = op->close;
+	driver->write = op->write;
+	driver->put_char = op->put_char;
+	driver->flush_chars = op->flush_chars;
+	driver->write_room = op->write_room;
+	driver->chars_in_buffer = op->chars_in_buffer;
+	driver->ioctl = op->ioctl;
+	driver->set_termios = op->set_termios;
+	driver->throttle = op->throttle;
+	driver->unthrottle = op->unthrottle;
+	driver->stop = op->stop;
+	driver->start = op->start;
+	driver->hangup = op->hangup;
+	driver->break_ctl = op->break_ctl;
+	driver->flush_buffer = op->flush_buffer;
+	driver->set_ldisc = op->set_ldisc;
+	driver->wait_until_sent = op->wait_until_sent;
+	driver->send_xchar = op->send_xchar;
+}
+
+struct tty_driver *kstub_tty_driver;
+
+int tty_register_driver(struct tty_driver *driver)
+{
+	kstub_tty_driver = driver;
+	return 0;
+}
+
+int tty_unregister_driver(struct tty_driver *driver)
+{
+	kstub_tty_driver = NULL;
+	return 0;
+}
+
+void stop_tty(struct tty_struct *tty)
+{
+	if (tty->stopped)
+		return;
+	tty->stopped = 1;
+	if (tty->driver->stop)
+		tty->driver->stop(tty);
+}
+
+void start_tty(struct tty_struct *tty)
+{
+	if (!tty->stopped || tty->flow_stopped)
+		return;
+	tty->stopped = 0;
+	if (tty->driver->start)
+		tty->driver->start(tty);
+}
+
+void do_SAK(struct tty_struct *tty)
+{
+}
+
+void ctrl_alt_del(void)
+{
+}
+
+/*
+ * Input queued by the drivers is counted and thrown away when the line
+ * discipline would have taken it: rec_open() makes this the flip work.
+ */
+unsigned long kstub_flip_flushes, kstub_flip_bytes;
+
+void kstub_flush_to_ldisc(void *private_)
+{
+	struct tty_struct *tty = private_;
+
+	kstub_flip_flushes++;
+	kstub_flip_bytes += tty->flip.count;
+	tty->flip.count = 0;
+	tty->flip.char_buf_ptr = (char *) tty->flip.char_buf;
+	tty->flip.flag_buf_ptr = (unsigned char *) tty->flip.flag_buf;
+}
+
+void tty_flip_buffer_push(struct tty_struct *tty)
+{
+	if (tty->low_latency)
+		kstub_flush_to_ldisc(tty);
+	else
+		schedule_delayed_work(&tty->flip.work, 1);
+}
+
+struct tty_ldisc *tty_ldisc_ref(struct tty_struct *tty)
+{
+	return NULL;
+}
+
+struct tty_ldisc *tty_ldisc_ref_wait(struct tty_struct *tty)
+{
+	return &tty->ldisc;
+}
+
+void tty_ldisc_deref(struct tty_ldisc *ld)
+{
+}
+
+void tty_ldisc_flush(struct tty_struct *tty)
+{
+}
@@ -0,0 +1,166 @@
+/*
+ * mapbench.c - load the same unicode map on every VC, the way setfont
+ * does on each console of a multi-head box, and report what it costs:
+ * the time PIO_UNIMAPCLR and PIO_UNIMAP take per VC, how many distinct
+ * maps the VCs end up with, and the memory those maps hold.
+ *
+ * The VCs, all MAX_NR_CONSOLES of them by default, are spread over a
+ * few displays: a display has at most MAX_NR_USER_CONSOLES, and unimaps
+ * used to be shared between the consoles of one display only.  Runs
+ * alternate between two maps of the same code points with the glyphs
+ * shifted, as when switching between two fonts; the memory reported is
+ * what the heap grew by from when all VCs had the default map.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <getopt.h>
+#include <malloc.h>
+
+#include <linux/tty.h>
+#include <linux/vt_kern.h>
+
+#include "recordcon.h"
+
+#define MAX_HEADS	8
+
+static struct vc_data *vcs[MAX_NR_CONSOLES];
+static int nr_vcs;
+
+#define MAP_SIZE	928
+
+static struct unipair maps[2][MAP_SIZE];
+
+/*
+ * A 512 glyph font: ASCII and Latin-1 onwards, Cyrillic, and the box
+ * drawing and block characters, so the map spans a few pages.
+ */
+static void make_map(struct unipair *map, int shift)
+{
+	int i, n = 0;
+
+	for (i = 0; i < 512; i++, n++) {
+		map[n].unicode = 0x20 + i;
+		map[n].fontpos = (i + shift) % 512;
+	}
+	for (i = 0; i < 256; i++, n++) {
+		map[n].unicode = 0x400 + i;
+		map[n].fontpos = (256 + i + shift) % 512;
+	}
+	for (i = 0; i < 160; i++, n++) {
+		map[n].unicode = 0x2500 + i;
+		map[n].fontpos = (352 + i + shift) % 512;
+	}
+}
+
+static int distinct_maps(void)
+{
+	int i, j, n = 0;
+
+	for (i = 0; i < nr_vcs; i++) {
+		for (j = 0; j < i; j++)
+			if (*vcs[j]->vc_uni_pagedir_loc ==
+			    *vcs[i]->vc_uni_pagedir_loc)
+				break;
+		n += j == i;
+	}
+	return n;
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: mapbench [options]\n"
+		"  -H HEADS      displays the VCs are spread over (4)\n"
+		"  -n VCS        VCs in all, at most %d per display (%d)\n"
+		"  -r RUNS       runs, best one reported (5)\n",
+		MAX_NR_USER_CONSOLES, MAX_NR_CONSOLES);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	struct rec_display *disp;
+	struct tty_struct *tty;
+	unsigned long long best = ~0ULL, t;
+	long base, bytes;
+	int index[MAX_NR_CONSOLES];
+	int nr_heads = 4, count = MAX_NR_CONSOLES, runs = 5;
+	int i, j, r, opt, err = 0;
+
+	while ((opt = getopt(argc, argv, "H:n:r:h")) != -1) {
+		switch (opt) {
+		case 'H':
+			nr_heads = atoi(optarg);
+			break;
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 'r':
+			runs = atoi(optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind != argc || nr_heads < 1 || nr_heads > MAX_HEADS ||
+	    count < nr_heads || count > MAX_NR_CONSOLES ||
+	    count > nr_heads * MAX_NR_USER_CONSOLES || runs < 1)
+		usage();
+
+	for (i = 0; i < nr_heads; i++) {
+		/* The first heads take the remainder */
+		int n = count / nr_heads + (i < count % nr_heads);
+
+		disp = rec_add_display(&rec_con, 80, 25, n);
+		if (!disp) {
+			fprintf(stderr, "mapbench: cannot set up display %d\n", i);
+			return 1;
+		}
+		for (j = 0; j < n; j++)
+			index[nr_vcs++] = disp->vt.first_vc + j;
+	}
+	if (rec_start()) {
+		fprintf(stderr, "mapbench: vty_init failed\n");
+		return 1;
+	}
+	for (i = 0; i < nr_vcs; i++) {
+		tty = rec_open(index[i]);
+		if (!tty) {
+			fprintf(stderr, "mapbench: cannot open VC %d\n",
+				index[i] + 1);
+			return 1;
+		}
+		vcs[i] = tty->driver_data;
+	}
+	make_map(maps[0], 0);
+	make_map(maps[1], 1);
+
+	base = mallinfo2().uordblks;
+	for (r = 0; r < runs; r++) {
+		t = sched_clock();
+		for (i = 0; i < nr_vcs; i++) {
+			err |= con_clear_unimap(vcs[i], NULL);
+			err |= con_set_unimap(vcs[i], MAP_SIZE, maps[r & 1]);
+		}
+		t = sched_clock() - t;
+		if (t < best)
+			best = t;
+	}
+	bytes = mallinfo2().uordblks - base;
+	if (err) {
+		fprintf(stderr, "mapbench: loading the map failed\n");
+		return 1;
+	}
+
+	printf("%-6s %6s %8s %10s %6s %8s\n", "heads", "vcs", "entries",
+	       "us/vc", "maps", "kB");
+	printf("%-6d %6d %8d %10.2f %6d %8.1f\n", nr_heads, nr_vcs, MAP_SIZE,
+	       best / 1e3 / nr_vcs, distinct_maps(), bytes / 1024.0);
+	if (kstub_warnings)
+		fprintf(stderr, "mapbench: %lu warnings\n", kstub_warnings);
+	return kstub_warnings != 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * recordcon.c - a console backend that records what vt.c asks of it.
+ *
+ * Every call is counted per display and can be logged; the cells are
+ * kept in a shadow of the display, so a test can check that what the
+ * backend was told adds up to the screen buffer.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <linux/tty.h>
+#include <linux/vt_kern.h>
+#include <linux/vt_buffer.h>
+
+#include "recordcon.h"
+
+static int rec_cols = 80, rec_rows = 25;
+
+#define disp_of(vc)	rec_display_of(vc)
+#define cell_of(d, y, x) ((d)->shadow + (y) * (d)->cols + (x))
+#define trace(d, ...)	do { if ((d)->trace) fprintf((d)->trace, __VA_ARGS__); } while (0)
+
+static const char *rec_startup(struct vt_struct *vt, int init)
+{
+	struct rec_display *disp = container_of(vt, struct rec_display, vt);
+
+	vt->cursor_original = -1;
+	disp->shadow = calloc(disp->cols * disp->rows, sizeof(*disp->shadow));
+	return disp->shadow ? "recording" : NULL;
+}
+
+static void rec_init(struct vc_data *vc, int init)
+{
+	struct rec_display *disp = disp_of(vc);
+
+	vc->vc_can_do_color = 1;
+	vc->vc_cols = disp->cols;
+	vc->vc_rows = disp->rows;
+}
+
+static void rec_deinit(struct vc_data *vc)
+{
+}
+
+static void rec_clear(struct vc_data *vc, int sy, int sx, int height, int width)
+{
+	struct rec_display *disp = disp_of(vc);
+	int y, x;
+
+	disp->stats.clear++;
+	disp->stats.clear_cells += height * width;
+	trace(disp, "clear %d,%d %dx%d\n", sy, sx, height, width);
+	for (y = sy; y < sy + height; y++)
+		for (x = sx; x < sx + width; x++)
+			*cell_of(disp, y, x) = vc->vc_video_erase_char;
+}
+
+static void rec_putc(struct vc_data *vc, int c, int y, int x)
+{
+	struct rec_display *disp = disp_of(vc);
+
+	disp->stats.putc++;
+	trace(disp, "putc %d,%d %04x\n", y, x, c & 0xffff);
+	*cell_of(disp, y, x) = c;
+}
+
+static void rec_putcs(struct vc_data *vc, const unsigned short *s, int count,
+		      int y, int x)
+{
+	struct rec_display *disp = disp_of(vc);
+	int i;
+
+	disp->stats.putcs++;
+	disp->stats.putcs_cells += count;
+	trace(disp, "putcs %d,%d %d attr %02x\n", y, x, count, scr_readw(s) >> 8);
+	for (i = 0; i < count; i++)
+		*cell_of(disp, y, x + i) = scr_readw(s + i);
+}
+
+static void rec_cursor(struct vc_data *vc, int mode)
+{
+	struct rec_display *disp = disp_of(vc);
+
+	disp->stats.cursor++;
+	trace(disp, "cursor %d\n", mode);
+}
+
+/* Moves the shadow only; vt.c still scrolls its own buffer */
+static int rec_scroll_region(struct vc_data *vc, int t, int b, int dir, int nr)
+{
+	struct rec_display *disp = disp_of(vc);
+	int cols = disp->cols, i;
+	unsigned short *fill;
+
+	disp->stats.scroll++;
+	disp->stats.scroll_lines += nr;
+	trace(disp, "scroll %d-%d %s %d\n", t, b, dir == SM_UP ? "up" : "down", nr);
+	if (dir == SM_UP) {
+		memmove(cell_of(disp, t, 0), cell_of(disp, t + nr, 0),
+			(b - t - nr) * cols * sizeof(*disp->shadow));
+		fill = cell_of(disp, b - nr, 0);
+	} else {
+		memmove(cell_of(disp, t + nr, 0), cell_of(disp, t, 0),
+			(b - t - nr) * cols * sizeof(*disp->shadow));
+		fill = cell_of(disp, t, 0);
+	}
+	for (i = 0; i < nr * cols; i++)
+		fill[i] = vc->vc_video_erase_char;
+	return 0;
+}
+
+static void rec_bmove(struct vc_data *vc, int sy, int sx, int dy, int dx,
+		      int height, int width)
+{
+	struct rec_display *disp = disp_of(vc);
+	int y;
+
+	disp->stats.bmove++;
+	disp->stats.bmove_cells += height * width;
+	trace(disp, "bmove %d,%d -> %d,%d %dx%d\n", sy, sx, dy, dx, height, width);
+	if (dy <= sy) {
+		for (y = 0; y < height; y++)
+			memmove(cell_of(disp, dy + y, dx), cell_of(disp, sy + y, sx),
+				width * sizeof(*disp->shadow));
+	} else {
+		for (y = height - 1; y >= 0; y--)
+			memmove(cell_of(disp, dy + y, dx), cell_of(disp, sy + y, sx),
+				width * sizeof(*disp->shadow));
+	}
+}
+
+static int rec_switch(struct vc_data *vc)
+{
+	return 1;	/* redraw everything */
+}
+
+static int rec_blank(struct vc_data *vc, int blank, int mode_switch)
+{
+	return 0;
+}
+
+static int rec_set_palette(struct vc_data *vc, unsigned char *table)
+{
+	return 0;
+}
+
+static int rec_scroll(struct vc_data *vc, int lines)
+{
+	return 0;
+}
+
+const struct consw rec_con = {
+	.con_startup		= rec_startup,
+	.con_init		= rec_init,
+	.con_deinit		= rec_deinit,
+	.con_clear		= rec_clear,
+	.con_putc		= rec_putc,
+	.con_putcs		= rec_putcs,
+	.con_cursor		= rec_cursor,
+	.con_scroll_region	= rec_scroll_region,
+	.con_bmove		= rec_bmove,
+	.con_switch		= rec_switch,
+	.con_blank		= rec_blank,
+	.con_set_palette	= rec_set_palette,
+	.con_scroll		= rec_scroll,
+};
+
+/* A dumb display: everything that moves is drawn again */
+const struct consw rec_con_plain = {
+	.con_startup		= rec_startup,
+	.con_init		= rec_init,
+	.con_deinit		= rec_deinit,
+	.con_clear		= rec_clear,
+	.con_putc		= rec_putc,
+	.con_putcs		= rec_putcs,
+	.con_cursor		= rec_cursor,
+	.con_switch		= rec_switch,
+	.con_blank		= rec_blank,
+	.con_set_palette	= rec_set_palette,
+	.con_scroll		= rec_scroll,
+};
+
+/*
+ * Set up a display with nr_vcs consoles; its first one is shown.  All
+ * displays have to be added before rec_start().
+ */
+struct rec_display *rec_add_display(const struct consw *sw, int cols, int rows,
+				    int nr_vcs)
+{
+	struct rec_display *disp = calloc(1, sizeof(*disp));
+
+	if (!disp)
+		return NULL;
+	disp->cols = cols ? cols : rec_cols;
+	disp->rows = rows ? rows : rec_rows;
+	disp->vt.vt_sw = sw;
+	disp->vt.kmalloced = 1;
+	if (!vt_map_display(&disp->vt, 1, nr_vcs)) {
+		free(disp);
+		return NULL;
+	}
+	return disp;
+}
+
+/* Registers the tty driver, i.e. vty_init() */
+int rec_start(void)
+{
+	return vty_init();
+}
+
+/* Opens /dev/tty<index + 1> */
+struct tty_struct *rec_open(int index)
+{
+	struct tty_struct *tty = calloc(1, sizeof(*tty));
+
+	if (!tty)
+		return NULL;
+	tty->magic = TTY_MAGIC;
+	tty->driver = kstub_tty_driver;
+	tty->index = index;
+	tty->count = 1;
+	sema_init(&tty->termios_sem, 1);
+	tty->flip.char_buf_ptr = (char *) tty->flip.char_buf;
+	tty->flip.flag_buf_ptr = (unsigned char *) tty->flip.flag_buf;
+	INIT_WORK(&tty->flip.work, kstub_flush_to_ldisc, tty);
+	INIT_LIST_HEAD(&tty->tty_files);
+	if (tty->driver->open(tty, NULL) < 0 || !tty->driver_data) {
+		free(tty);
+		return NULL;
+	}
+	return tty;
+}
+
+/* Write all of buf, the way write(2) on the tty would hand it down */
+int rec_write(struct tty_struct *tty, const unsigned char *buf, int count)
+{
+	int done = 0, n;
+
+	while (done < count) {
+		n = tty->driver->write(tty, buf + done, count - done);
+		if (n <= 0)
+			break;
+		done += n;
+	}
+	run_scheduled_work();
+	return done;
+}
+
+/*
+ * Compare the shadow with the screen buffer of the console shown.
+ * Returns the number of cells that differ; the first few are reported.
+ */
+int rec_verify(struct rec_display *disp)
+{
+	struct vc_data *vc = disp->vt.fg_console;
+	const unsigned short *screen = (const unsigned short *) vc->vc_origin;
+	int i, bad = 0;
+
+	if (disp->vt.vt_blanked || vc->vc_mode != KD_TEXT)
+		return 0;
+	for (i = 0; i < disp->cols * disp->rows; i++) {
+		if (disp->shadow[i] == scr_readw(screen + i))
+			continue;
+		if (bad++ < 4)
+			fprintf(stderr, "vt %d: cell %d,%d shows %04x, buffer has %04x\n",
+				disp->vt.vt_num, i / disp->cols, i % disp->cols,
+				disp->shadow[i], scr_readw(screen + i));
+	}
+	return bad;
+}
+
+void rec_reset_stats(struct rec_display *disp)
+{
+	memset(&disp->stats, 0, sizeof(disp->stats));
+}
+
+/* Calls that reach the display, not counting the cursor */
+unsigned long rec_calls(const struct rec_stats *s)
+{
+	return s->putcs + s->putc + s->bmove + s->scroll + s->clear;
+}
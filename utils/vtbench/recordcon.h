@@ -0,0 +1,58 @@
+/*
+ * recordcon.h - a console backend that records what vt.c asks of it.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef _RECORDCON_H
+#define _RECORDCON_H
+
+#include <stdio.h>
+
+#include <linux/tty.h>
+#include <linux/vt_kern.h>
+
+/* Calls made to one display, and the cells they touched */
+struct rec_stats {
+	unsigned long putcs, putcs_cells;
+	unsigned long putc;
+	unsigned long bmove, bmove_cells;
+	unsigned long scroll, scroll_lines;
+	unsigned long clear, clear_cells;
+	unsigned long cursor;
+};
+
+/*
+ * One display.  The shadow holds what the backend has been told to
+ * show, so it can be checked against the screen buffer.
+ */
+struct rec_display {
+	struct vt_struct vt;
+	int cols, rows;
+	unsigned short *shadow;
+	struct rec_stats stats;
+	FILE *trace;		/* Log every call here, if set */
+};
+
+/* With con_bmove and con_scroll_region, and without (full repaints) */
+extern const struct consw rec_con;
+extern const struct consw rec_con_plain;
+
+extern struct rec_display *rec_add_display(const struct consw *sw, int cols,
+					   int rows, int nr_vcs);
+extern int rec_start(void);
+extern struct tty_struct *rec_open(int index);
+extern int rec_write(struct tty_struct *tty, const unsigned char *buf, int count);
+extern int rec_verify(struct rec_display *disp);
+extern void rec_reset_stats(struct rec_display *disp);
+extern unsigned long rec_calls(const struct rec_stats *s);
+
+static inline struct rec_display *rec_display_of(struct vc_data *vc)
+{
+	return container_of(vc->display_fg, struct rec_display, vt);
+}
+
+#endif
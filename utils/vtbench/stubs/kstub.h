@@ -0,0 +1,444 @@
+/*
+ * kstub.h - just enough of the kernel API to build the console code
+ * in drivers/char as an ordinary userspace program.
+ *
+ * Every stub header under stubs/linux and stubs/asm pulls this in; the
+ * implementations live in kstub.c.  Locks are real (pthreads), so the
+ * harness can run several writers at once; deferred work only runs when
+ * the harness calls run_scheduled_work().
+ */
+#ifndef _VTBENCH_KSTUB_H
+#define _VTBENCH_KSTUB_H
+
+#include <stddef.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <linux/types.h>	/* the host's, through stubs/linux/types.h */
+
+/* Configuration the console code is built with */
+#define CONFIG_VT		1
+#define CONFIG_VT_CONSOLE	1
+#define CONFIG_BASE_SMALL	0
+#define CONFIG_LEGACY_PTY_COUNT	256
+#define CONFIG_X86		1	/* keyboard.c: the PC raw mode */
+
+/* Compiler and section annotations */
+#define __user
+#define __iomem
+#define __init
+#define __exit
+#define __initdata
+#define __devinit
+#define __devexit
+#define __setup(str, fn) \
+	static int (*__setup_##fn)(char *) __attribute__((unused)) = fn;
+#define __stringify_1(x)	#x
+#define __stringify(x)		__stringify_1(x)
+#define likely(x)		__builtin_expect(!!(x), 1)
+#define unlikely(x)		__builtin_expect(!!(x), 0)
+#define barrier()		__asm__ __volatile__("" : : : "memory")
+#define mb()			__sync_synchronize()
+#define rmb()			__sync_synchronize()
+#define wmb()			__sync_synchronize()
+#define smp_mb()		__sync_synchronize()
+#define xchg(ptr, v)		__atomic_exchange_n(ptr, v, __ATOMIC_SEQ_CST)
+
+/* Modules */
+struct module;
+#define THIS_MODULE		((struct module *) 0)
+#define EXPORT_SYMBOL(sym)
+#define EXPORT_SYMBOL_GPL(sym)
+#define MODULE_LICENSE(s)
+#define MODULE_AUTHOR(s)
+#define MODULE_DESCRIPTION(s)
+#define MODULE_PARM(v, t)
+#define MODULE_DEVICE_TABLE(type, name)
+#define module_init(fn) \
+	static int (*__initcall_##fn)(void) __attribute__((unused)) = fn;
+#define module_exit(fn) \
+	static void (*__exitcall_##fn)(void) __attribute__((unused)) = fn;
+#define console_initcall(fn)	module_init(fn)
+#define try_module_get(m)	((void) (m), 1)
+#define __module_get(m)		((void) (m))
+#define module_put(m)		((void) (m))
+
+/* Arithmetic helpers */
+#define BITS_PER_LONG		(8 * (int) sizeof(long))
+#define PAGE_SIZE		4096UL
+#define PAGE_SHIFT		12
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define container_of(ptr, type, member) \
+	((type *) ((char *) (ptr) - offsetof(type, member)))
+#define min(x, y)		((x) < (y) ? (x) : (y))
+#define max(x, y)		((x) > (y) ? (x) : (y))
+#define min_t(type, x, y)	((type) (x) < (type) (y) ? (type) (x) : (type) (y))
+#define max_t(type, x, y)	((type) (x) > (type) (y) ? (type) (x) : (type) (y))
+#define NBITS(x)		((((x) - 1) / BITS_PER_LONG) + 1)
+#define BITS_TO_LONGS(n)	(((n) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define simple_strtoul		strtoul
+#define MINORBITS		20
+#define MKDEV(ma, mi)		(((ma) << MINORBITS) | (mi))
+#define MAJOR(dev)		((unsigned int) ((dev) >> MINORBITS))
+#define MINOR(dev)		((unsigned int) ((dev) & ((1U << MINORBITS) - 1)))
+
+/* Kernel private errors */
+#define ERESTARTSYS		512
+#define ENOIOCTLCMD		515
+
+/* Messages and assertions.  Warnings are counted so tests can fail on them. */
+#define KERN_EMERG		"<0>"
+#define KERN_ALERT		"<1>"
+#define KERN_CRIT		"<2>"
+#define KERN_ERR		"<3>"
+#define KERN_WARNING		"<4>"
+#define KERN_NOTICE		"<5>"
+#define KERN_INFO		"<6>"
+#define KERN_DEBUG		"<7>"
+extern int printk(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+extern void panic(const char *fmt, ...) __attribute__((noreturn));
+extern unsigned long kstub_warnings;
+extern void kstub_warn(const char *file, int line);
+#define WARN_ON(cond)	do { if (unlikely(cond)) kstub_warn(__FILE__, __LINE__); } while (0)
+#define BUG()		panic("BUG at %s:%d", __FILE__, __LINE__)
+#define BUG_ON(cond)	do { if (unlikely(cond)) BUG(); } while (0)
+extern int oops_in_progress;
+
+/* Lists */
+struct list_head {
+	struct list_head *next, *prev;
+};
+#define LIST_HEAD_INIT(name)	{ &(name), &(name) }
+#define LIST_HEAD(name)		struct list_head name = LIST_HEAD_INIT(name)
+#define INIT_LIST_HEAD(ptr)	do { (ptr)->next = (ptr); (ptr)->prev = (ptr); } while (0)
+
+static inline void __list_add(struct list_head *new, struct list_head *prev,
+			      struct list_head *next)
+{
+	next->prev = new;
+	new->next = next;
+	new->prev = prev;
+	prev->next = new;
+}
+
+static inline void list_add(struct list_head *new, struct list_head *head)
+{
+	__list_add(new, head, head->next);
+}
+
+static inline void list_add_tail(struct list_head *new, struct list_head *head)
+{
+	__list_add(new, head->prev, head);
+}
+
+static inline void list_del(struct list_head *entry)
+{
+	entry->next->prev = entry->prev;
+	entry->prev->next = entry->next;
+	entry->next = entry->prev = entry;
+}
+
+static inline void list_del_init(struct list_head *entry)
+{
+	list_del(entry);
+}
+
+static inline int list_empty(const struct list_head *head)
+{
+	return head->next == head;
+}
+
+#define list_entry(ptr, type, member)	container_of(ptr, type, member)
+#define list_for_each(pos, head) \
+	for (pos = (head)->next; pos != (head); pos = pos->next)
+#define list_for_each_safe(pos, n, head) \
+	for (pos = (head)->next, n = pos->next; pos != (head); pos = n, n = pos->next)
+#define list_for_each_entry(pos, head, member) \
+	for (pos = list_entry((head)->next, typeof(*pos), member); \
+	     &pos->member != (head); \
+	     pos = list_entry(pos->member.next, typeof(*pos), member))
+
+struct hlist_node {
+	struct hlist_node *next, **pprev;
+};
+struct hlist_head {
+	struct hlist_node *first;
+};
+#define hlist_entry(ptr, type, member)	container_of(ptr, type, member)
+
+static inline void hlist_add_head(struct hlist_node *n, struct hlist_head *h)
+{
+	if ((n->next = h->first))
+		h->first->pprev = &n->next;
+	h->first = n;
+	n->pprev = &h->first;
+}
+
+static inline void hlist_del_init(struct hlist_node *n)
+{
+	if (n->pprev) {
+		if ((*n->pprev = n->next))
+			n->next->pprev = n->pprev;
+		n->next = NULL;
+		n->pprev = NULL;
+	}
+}
+
+#define hlist_for_each_entry(tpos, pos, head, member) \
+	for (pos = (head)->first; \
+	     pos && ((tpos = hlist_entry(pos, typeof(*tpos), member)), 1); \
+	     pos = pos->next)
+
+/* Atomics and bit operations */
+typedef struct { volatile int counter; } atomic_t;
+#define ATOMIC_INIT(i)		{ (i) }
+#define atomic_read(v)		((v)->counter)
+#define atomic_set(v, i)	((v)->counter = (i))
+#define atomic_inc(v)		__sync_add_and_fetch(&(v)->counter, 1)
+#define atomic_dec(v)		__sync_sub_and_fetch(&(v)->counter, 1)
+#define atomic_dec_and_test(v)	(__sync_sub_and_fetch(&(v)->counter, 1) == 0)
+
+#define BIT_WORD(nr)		((nr) / BITS_PER_LONG)
+#define BIT_MASK(nr)		(1UL << ((nr) % BITS_PER_LONG))
+
+static inline void set_bit(int nr, volatile unsigned long *addr)
+{
+	__sync_fetch_and_or(addr + BIT_WORD(nr), BIT_MASK(nr));
+}
+
+static inline void clear_bit(int nr, volatile unsigned long *addr)
+{
+	__sync_fetch_and_and(addr + BIT_WORD(nr), ~BIT_MASK(nr));
+}
+
+static inline void change_bit(int nr, volatile unsigned long *addr)
+{
+	__sync_fetch_and_xor(addr + BIT_WORD(nr), BIT_MASK(nr));
+}
+
+static inline int test_bit(int nr, const volatile unsigned long *addr)
+{
+	return (addr[BIT_WORD(nr)] & BIT_MASK(nr)) != 0;
+}
+
+static inline int test_and_set_bit(int nr, volatile unsigned long *addr)
+{
+	return (__sync_fetch_and_or(addr + BIT_WORD(nr), BIT_MASK(nr)) & BIT_MASK(nr)) != 0;
+}
+
+static inline int test_and_clear_bit(int nr, volatile unsigned long *addr)
+{
+	return (__sync_fetch_and_and(addr + BIT_WORD(nr), ~BIT_MASK(nr)) & BIT_MASK(nr)) != 0;
+}
+
+static inline int test_and_change_bit(int nr, volatile unsigned long *addr)
+{
+	return (__sync_fetch_and_xor(addr + BIT_WORD(nr), BIT_MASK(nr)) & BIT_MASK(nr)) != 0;
+}
+
+#define __set_bit(nr, addr)	set_bit(nr, addr)
+#define __clear_bit(nr, addr)	clear_bit(nr, addr)
+
+extern int find_next_bit(const unsigned long *addr, int size, int offset);
+#define find_first_bit(addr, size)	find_next_bit(addr, size, 0)
+
+/* Memory */
+#define GFP_KERNEL		0
+#define GFP_ATOMIC		1
+#define GFP_USER		2
+extern void *kmalloc(size_t size, int flags);
+extern void kfree(const void *p);
+extern void *vmalloc(unsigned long size);
+extern void vfree(void *p);
+extern void *alloc_bootmem(unsigned long size);
+extern void free_bootmem(unsigned long addr, unsigned long size);
+
+/* User copies: the harness only ever passes its own memory */
+#define VERIFY_READ		0
+#define VERIFY_WRITE		1
+#define access_ok(type, addr, size)	1
+#define verify_area(type, addr, size)	0
+#define get_user(x, ptr)	({ (x) = *(ptr); 0; })
+#define put_user(x, ptr)	({ *(ptr) = (x); 0; })
+#define __get_user(x, ptr)	get_user(x, ptr)
+#define __put_user(x, ptr)	put_user(x, ptr)
+
+static inline unsigned long copy_to_user(void *to, const void *from, unsigned long n)
+{
+	memcpy(to, from, n);
+	return 0;
+}
+
+static inline unsigned long copy_from_user(void *to, const void *from, unsigned long n)
+{
+	memcpy(to, from, n);
+	return 0;
+}
+
+/* Time */
+#define HZ			100
+extern volatile unsigned long jiffies;
+#define time_after(a, b)	((long) (b) - (long) (a) < 0)
+#define time_before(a, b)	time_after(b, a)
+extern unsigned long long sched_clock(void);
+
+/* Tasks */
+#define TASK_RUNNING		0
+#define TASK_INTERRUPTIBLE	1
+#define TASK_UNINTERRUPTIBLE	2
+#define CAP_SYS_ADMIN		21
+#define CAP_SYS_TTY_CONFIG	26
+#define CAP_SYS_RESOURCE	24
+#define CAP_KILL		5
+struct tty_struct;
+struct signal_struct {
+	struct tty_struct *tty;
+	int leader;
+};
+struct task_struct {
+	int pid;
+	struct signal_struct *signal;
+};
+extern struct task_struct *current;
+#define capable(cap)		1
+#define in_interrupt()		0
+#define in_atomic()		0
+#define might_sleep()		do { } while (0)
+#define set_current_state(s)	do { } while (0)
+#define signal_pending(t)	0
+extern void schedule(void);
+extern int cond_resched(void);
+extern int kill_pg(int pgrp, int sig, int priv);
+extern int kill_proc(int pid, int sig, int priv);
+struct pt_regs;
+#define show_regs(regs)		do { } while (0)
+#define show_mem()		do { } while (0)
+#define show_state()		do { } while (0)
+
+/*
+ * Sleeping locks.  A semaphore may be released by another task than
+ * the one that took it, so this is a counter under a mutex rather than
+ * a bare pthread mutex.
+ */
+struct semaphore {
+	int count;
+	pthread_mutex_t mutex;
+	pthread_cond_t wait;
+};
+#define __SEMAPHORE_INITIALIZER(name, n) \
+	{ (n), PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER }
+#define DECLARE_MUTEX(name) \
+	struct semaphore name = __SEMAPHORE_INITIALIZER(name, 1)
+#define DECLARE_MUTEX_LOCKED(name) \
+	struct semaphore name = __SEMAPHORE_INITIALIZER(name, 0)
+extern void sema_init(struct semaphore *sem, int val);
+#define init_MUTEX(sem)		sema_init(sem, 1)
+#define init_MUTEX_LOCKED(sem)	sema_init(sem, 0)
+extern void down(struct semaphore *sem);
+extern int down_interruptible(struct semaphore *sem);
+extern int down_trylock(struct semaphore *sem);
+extern void up(struct semaphore *sem);
+
+typedef pthread_mutex_t spinlock_t;
+#define SPIN_LOCK_UNLOCKED	PTHREAD_MUTEX_INITIALIZER
+#define spin_lock_init(l)	pthread_mutex_init(l, NULL)
+#define spin_lock(l)		pthread_mutex_lock(l)
+#define spin_unlock(l)		pthread_mutex_unlock(l)
+#define spin_lock_irq(l)	pthread_mutex_lock(l)
+#define spin_unlock_irq(l)	pthread_mutex_unlock(l)
+#define spin_lock_bh(l)		pthread_mutex_lock(l)
+#define spin_unlock_bh(l)	pthread_mutex_unlock(l)
+#define spin_lock_irqsave(l, f)	 do { (f) = 0; pthread_mutex_lock(l); } while (0)
+#define spin_unlock_irqrestore(l, f) do { (void) (f); pthread_mutex_unlock(l); } while (0)
+#define local_irq_save(f)	do { (f) = 0; } while (0)
+#define local_irq_restore(f)	do { (void) (f); } while (0)
+#define local_irq_disable()	do { } while (0)
+#define local_irq_enable()	do { } while (0)
+
+/* Wait queues: nobody ever sleeps on them in the harness */
+typedef struct {
+	int sleepers;
+} wait_queue_head_t;
+typedef struct {
+	int unused;
+} wait_queue_t;
+#define DECLARE_WAIT_QUEUE_HEAD(name)	wait_queue_head_t name = { 0 }
+#define DECLARE_WAITQUEUE(name, tsk)	wait_queue_t name = { 0 }
+#define init_waitqueue_head(q)		((q)->sleepers = 0)
+#define add_wait_queue(q, w)		do { } while (0)
+#define remove_wait_queue(q, w)		do { } while (0)
+#define wake_up(q)			do { } while (0)
+#define wake_up_interruptible(q)	do { } while (0)
+#define wait_event_interruptible(q, cond) 0
+
+/*
+ * Deferred work.  Queued items run, in order, from run_scheduled_work()
+ * or flush_scheduled_work(); delays are ignored.
+ */
+struct work_struct {
+	void (*func)(void *);
+	void *data;
+	int pending;
+	struct work_struct *next;
+};
+#define __WORK_INITIALIZER(n, f, d)	{ (f), (d), 0, NULL }
+#define DECLARE_WORK(n, f, d)	struct work_struct n = __WORK_INITIALIZER(n, f, d)
+#define INIT_WORK(w, f, d) \
+	do { (w)->func = (f); (w)->data = (d); (w)->pending = 0; (w)->next = NULL; } while (0)
+#define PREPARE_WORK(w, f, d)	do { (w)->func = (f); (w)->data = (d); } while (0)
+extern int schedule_work(struct work_struct *work);
+extern int schedule_delayed_work(struct work_struct *work, unsigned long delay);
+extern int cancel_delayed_work(struct work_struct *work);
+extern void flush_scheduled_work(void);
+extern int run_scheduled_work(void);
+#define keventd_up()		1
+
+/* Timers never fire; the harness has no use for blanking or beeps */
+struct timer_list {
+	unsigned long expires;
+	unsigned long data;
+	void (*function)(unsigned long);
+	int pending;
+};
+#define init_timer(t)		((t)->pending = 0)
+#define add_timer(t)		((t)->pending = 1)
+#define mod_timer(t, e)		({ (t)->expires = (e); (t)->pending = 1; 0; })
+#define del_timer(t)		((t)->pending = 0)
+#define del_timer_sync(t)	((t)->pending = 0)
+#define timer_pending(t)	((t)->pending)
+
+struct tasklet_struct {
+	void (*func)(unsigned long);
+	unsigned long data;
+	int disabled;
+	int scheduled;
+};
+#define DECLARE_TASKLET(n, f, d)	 struct tasklet_struct n = { (f), (d), 0, 0 }
+#define DECLARE_TASKLET_DISABLED(n, f, d) struct tasklet_struct n = { (f), (d), 1, 0 }
+#define tasklet_schedule(t)	((t)->scheduled = 1)
+#define tasklet_enable(t)	((t)->disabled = 0)
+#define tasklet_disable(t)	((t)->disabled = 1)
+
+/* Power management and device model pieces the VT structures embed */
+struct pm_dev;
+struct proc_dir_entry;
+struct fasync_struct;
+struct class_simple;
+
+/* The console lock, with the time spent waiting for it */
+extern unsigned long long kstub_console_wait_ns;
+
+/* The tty driver vty_init() registered */
+extern struct tty_driver *kstub_tty_driver;
+
+/* The flip work: how often input reached the ldisc, and how much */
+extern unsigned long kstub_flip_flushes, kstub_flip_bytes;
+void kstub_flush_to_ldisc(void *private_);
+
+#endif /* _VTBENCH_KSTUB_H */
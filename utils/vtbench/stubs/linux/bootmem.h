@@ -0,0 +1,2 @@
+/* Covered by the common stub layer */
+#include <kstub.h>
@@ -0,0 +1,2 @@
+/* devfs is not involved in the harness */
+#include <kstub.h>
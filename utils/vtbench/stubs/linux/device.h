@@ -0,0 +1,24 @@
+/*
+ * The piece of the driver model a display is registered through.
+ */
+#ifndef _VTBENCH_DEVICE_H
+#define _VTBENCH_DEVICE_H
+
+#include <kstub.h>
+
+struct class_device {
+	void	*class_data;
+	char	class_id[20];
+};
+
+struct class_device_attribute {
+	const char *name;
+	ssize_t (*show)(struct class_device *, char *);
+	ssize_t (*store)(struct class_device *, const char *, size_t);
+};
+
+#define CLASS_DEVICE_ATTR(_name, _mode, _show, _store) \
+	struct class_device_attribute class_device_attr_##_name = \
+		{ #_name, _show, _store }
+
+#endif
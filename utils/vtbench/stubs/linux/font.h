@@ -0,0 +1,17 @@
+/*
+ * Built-in console fonts.
+ */
+#ifndef _VTBENCH_FONT_H
+#define _VTBENCH_FONT_H
+
+#include <kstub.h>
+
+struct font_desc {
+	int	idx;
+	char	*name;
+	int	width, height;
+	void	*data;
+	int	pref;
+};
+
+#endif
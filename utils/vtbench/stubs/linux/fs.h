@@ -0,0 +1,40 @@
+/*
+ * Files as the tty and vcs entry points see them.
+ */
+#ifndef _VTBENCH_FS_H
+#define _VTBENCH_FS_H
+
+#include <kstub.h>
+
+struct inode {
+	dev_t	i_rdev;
+};
+
+struct dentry {
+	struct inode *d_inode;
+};
+
+struct file {
+	struct dentry *f_dentry;
+	loff_t	f_pos;
+	unsigned int f_flags;
+	void	*private_data;
+};
+
+struct poll_table_struct;
+typedef struct poll_table_struct poll_table;
+
+struct file_operations {
+	struct module *owner;
+	loff_t (*llseek)(struct file *, loff_t, int);
+	ssize_t (*read)(struct file *, char __user *, size_t, loff_t *);
+	ssize_t (*write)(struct file *, const char __user *, size_t, loff_t *);
+	unsigned int (*poll)(struct file *, struct poll_table_struct *);
+	int (*ioctl)(struct inode *, struct file *, unsigned int, unsigned long);
+	int (*open)(struct inode *, struct file *);
+	int (*release)(struct inode *, struct file *);
+};
+
+#define iminor(inode)	((unsigned int) ((inode)->i_rdev & 0xff))
+
+#endif
@@ -0,0 +1,18 @@
+/*
+ * The multiplicative hash of <linux/hash.h>.
+ */
+#ifndef _VTBENCH_HASH_H
+#define _VTBENCH_HASH_H
+
+#include <kstub.h>
+
+#define GOLDEN_RATIO_PRIME	0x9e370001UL
+
+static inline unsigned long hash_long(unsigned long val, unsigned int bits)
+{
+	unsigned long hash = val * GOLDEN_RATIO_PRIME;
+
+	return (hash & 0xffffffffUL) >> (32 - bits);
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * The event codes come from the host's <linux/input.h>; the in-kernel
+ * handler structures the keyboard driver binds through are added here.
+ */
+#ifndef _VTBENCH_INPUT_H
+#define _VTBENCH_INPUT_H
+
+#include <kstub.h>
+
+/* The host header wants <sys/ioctl.h>, whose termio clashes with the kernel's */
+#ifndef _SYS_IOCTL_H
+#define _SYS_IOCTL_H	1
+#include <asm/ioctl.h>
+#endif
+#include_next <linux/input.h>
+
+struct input_dev {
+	char	*name;
+	struct input_id id;
+	unsigned long evbit[NBITS(EV_MAX)];
+	unsigned long keybit[NBITS(KEY_MAX)];
+	unsigned long mscbit[NBITS(MSC_MAX)];
+	unsigned long ledbit[NBITS(LED_MAX)];
+	unsigned long sndbit[NBITS(SND_MAX)];
+	unsigned long led[NBITS(LED_MAX)];
+	unsigned long snd[NBITS(SND_MAX)];
+	unsigned long key[NBITS(KEY_MAX)];
+	int	rep[REP_MAX + 1];
+	unsigned int keycodemax;
+	unsigned int keycodesize;
+	void	*keycode;
+	struct pt_regs *regs;
+	int	(*event)(struct input_dev *dev, unsigned int type,
+			 unsigned int code, int value);
+	void	*private;
+};
+
+struct input_handle;
+
+struct input_device_id {
+	unsigned long flags;
+	unsigned long evbit[NBITS(EV_MAX)];
+	unsigned long keybit[NBITS(KEY_MAX)];
+	unsigned long driver_info;
+};
+
+#define INPUT_DEVICE_ID_MATCH_EVBIT	0x0001
+#define INPUT_DEVICE_ID_MATCH_KEYBIT	0x0002
+
+struct input_handler {
+	void	*private;
+	void	(*event)(struct input_handle *handle, unsigned int type,
+			 unsigned int code, int value);
+	struct input_handle *(*connect)(struct input_handler *handler,
+					struct input_dev *dev,
+					struct input_device_id *id);
+	void	(*disconnect)(struct input_handle *handle);
+	struct file_operations *fops;
+	int	minor;
+	char	*name;
+	struct input_device_id *id_table;
+	struct input_device_id *blacklist;
+};
+
+struct input_handle {
+	void	*private;
+	int	open;
+	char	*name;
+	struct input_dev *dev;
+	struct input_handler *handler;
+};
+
+extern void input_event(struct input_dev *dev, unsigned int type,
+			unsigned int code, int value);
+extern int input_open_device(struct input_handle *);
+extern void input_close_device(struct input_handle *);
+extern void input_register_handler(struct input_handler *);
+extern void input_unregister_handler(struct input_handler *);
+
+#define input_sync(dev)		input_event(dev, EV_SYN, SYN_REPORT, 0)
+
+#define BIT(x)			(1UL << ((x) % BITS_PER_LONG))
+#define LONG(x)			((x) / BITS_PER_LONG)
+
+#define INPUT_KEYCODE(dev, scancode) \
+	((dev)->keycodesize == 1 ? ((u8 *) (dev)->keycode)[scancode] : \
+	 (dev)->keycodesize == 2 ? ((u16 *) (dev)->keycode)[scancode] : \
+	 ((u32 *) (dev)->keycode)[scancode])
+
+#define SET_INPUT_KEYCODE(dev, scancode, val) ({			\
+	unsigned int __old = INPUT_KEYCODE(dev, scancode);		\
+	if ((dev)->keycodesize == 1)					\
+		((u8 *) (dev)->keycode)[scancode] = (val);		\
+	else if ((dev)->keycodesize == 2)				\
+		((u16 *) (dev)->keycode)[scancode] = (val);		\
+	else								\
+		((u32 *) (dev)->keycode)[scancode] = (val);		\
+	__old; })
+
+#endif
@@ -0,0 +1,13 @@
+/*
+ * The accent table, defined in kbdmap.c.
+ */
+#ifndef _VTBENCH_KBD_DIACR_H
+#define _VTBENCH_KBD_DIACR_H
+
+#include <kstub.h>
+#include <linux/kd.h>
+
+extern struct kbdiacr accent_table[];
+extern unsigned int accent_table_size;
+
+#endif
@@ -0,0 +1,20 @@
+/*
+ * The keysyms come from the host's <linux/keyboard.h>; the tables the
+ * kernel builds from defkeymap.map are declared here, and kbdmap.c
+ * has a small set of them.
+ */
+#ifndef _VTBENCH_KEYBOARD_H
+#define _VTBENCH_KEYBOARD_H
+
+#include <kstub.h>
+#include_next <linux/keyboard.h>
+
+extern unsigned short *key_maps[MAX_NR_KEYMAPS];
+extern unsigned short plain_map[NR_KEYS];
+extern unsigned int keymap_count;
+extern char *func_table[MAX_NR_FUNC];
+extern char func_buf[];
+extern char *funcbufptr;
+extern int funcbufsize, funcbufleft;
+
+#endif
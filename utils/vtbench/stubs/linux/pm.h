@@ -0,0 +1,2 @@
+/* Nothing from power management is used by the console code */
+#include <kstub.h>
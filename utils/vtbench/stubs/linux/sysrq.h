@@ -0,0 +1,2 @@
+/* No CONFIG_MAGIC_SYSRQ; nothing to declare */
+#include <kstub.h>
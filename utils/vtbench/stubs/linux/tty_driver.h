@@ -0,0 +1,97 @@
+/*
+ * The 2.6 tty driver interface, as far as the console drivers use it.
+ */
+#ifndef _VTBENCH_TTY_DRIVER_H
+#define _VTBENCH_TTY_DRIVER_H
+
+#include <kstub.h>
+#include <linux/termios.h>
+
+struct tty_struct;
+struct file;
+
+struct tty_operations {
+	int  (*open)(struct tty_struct *tty, struct file *filp);
+	void (*close)(struct tty_struct *tty, struct file *filp);
+	int  (*write)(struct tty_struct *tty, const unsigned char *buf, int count);
+	void (*put_char)(struct tty_struct *tty, unsigned char ch);
+	void (*flush_chars)(struct tty_struct *tty);
+	int  (*write_room)(struct tty_struct *tty);
+	int  (*chars_in_buffer)(struct tty_struct *tty);
+	int  (*ioctl)(struct tty_struct *tty, struct file *file,
+		      unsigned int cmd, unsigned long arg);
+	void (*set_termios)(struct tty_struct *tty, struct termios *old);
+	void (*throttle)(struct tty_struct *tty);
+	void (*unthrottle)(struct tty_struct *tty);
+	void (*stop)(struct tty_struct *tty);
+	void (*start)(struct tty_struct *tty);
+	void (*hangup)(struct tty_struct *tty);
+	void (*break_ctl)(struct tty_struct *tty, int state);
+	void (*flush_buffer)(struct tty_struct *tty);
+	void (*set_ldisc)(struct tty_struct *tty);
+	void (*wait_until_sent)(struct tty_struct *tty, int timeout);
+	void (*send_xchar)(struct tty_struct *tty, char ch);
+};
+
+struct tty_driver {
+	int	magic;
+	struct module	*owner;
+	const char	*driver_name;
+	const char	*name;
+	const char	*devfs_name;
+	int	name_base;
+	int	major;
+	int	minor_start;
+	int	minor_num;
+	int	num;
+	short	type;
+	short	subtype;
+	struct termios init_termios;
+	int	flags;
+	int	refcount;
+	struct tty_struct **ttys;
+	struct termios **termios;
+	struct termios **termios_locked;
+	void	*driver_state;
+
+	/* Copied from the tty_operations, as in the kernel */
+	int  (*open)(struct tty_struct *tty, struct file *filp);
+	void (*close)(struct tty_struct *tty, struct file *filp);
+	int  (*write)(struct tty_struct *tty, const unsigned char *buf, int count);
+	void (*put_char)(struct tty_struct *tty, unsigned char ch);
+	void (*flush_chars)(struct tty_struct *tty);
+	int  (*write_room)(struct tty_struct *tty);
+	int  (*chars_in_buffer)(struct tty_struct *tty);
+	int  (*ioctl)(struct tty_struct *tty, struct file *file,
+		      unsigned int cmd, unsigned long arg);
+	void (*set_termios)(struct tty_struct *tty, struct termios *old);
+	void (*throttle)(struct tty_struct *tty);
+	void (*unthrottle)(struct tty_struct *tty);
+	void (*stop)(struct tty_struct *tty);
+	void (*start)(struct tty_struct *tty);
+	void (*hangup)(struct tty_struct *tty);
+	void (*break_ctl)(struct tty_struct *tty, int state);
+	void (*flush_buffer)(struct tty_struct *tty);
+	void (*set_ldisc)(struct tty_struct *tty);
+	void (*wait_until_sent)(struct tty_struct *tty, int timeout);
+	void (*send_xchar)(struct tty_struct *tty, char ch);
+};
+
+#define TTY_DRIVER_INSTALLED		0x0001
+#define TTY_DRIVER_RESET_TERMIOS	0x0002
+#define TTY_DRIVER_REAL_RAW		0x0004
+#define TTY_DRIVER_NO_DEVFS		0x0008
+#define TTY_DRIVER_DEVPTS_MEM		0x0010
+
+#define TTY_DRIVER_TYPE_SYSTEM		0x0001
+#define TTY_DRIVER_TYPE_CONSOLE		0x0002
+#define TTY_DRIVER_TYPE_SERIAL		0x0003
+#define TTY_DRIVER_TYPE_PTY		0x0004
+
+extern struct tty_driver *alloc_tty_driver(int lines);
+extern void put_tty_driver(struct tty_driver *driver);
+extern void tty_set_operations(struct tty_driver *driver, struct tty_operations *op);
+extern int tty_register_driver(struct tty_driver *driver);
+extern int tty_unregister_driver(struct tty_driver *driver);
+
+#endif
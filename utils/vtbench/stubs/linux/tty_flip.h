@@ -0,0 +1,26 @@
+/*
+ * Queueing input on a tty, as in 2.6.
+ */
+#ifndef _VTBENCH_TTY_FLIP_H
+#define _VTBENCH_TTY_FLIP_H
+
+#include <linux/tty.h>
+
+extern void tty_flip_buffer_push(struct tty_struct *tty);
+
+static inline void tty_insert_flip_char(struct tty_struct *tty,
+					unsigned char ch, char flag)
+{
+	if (tty->flip.count < TTY_FLIPBUF_SIZE) {
+		tty->flip.count++;
+		*tty->flip.flag_buf_ptr++ = flag;
+		*tty->flip.char_buf_ptr++ = ch;
+	}
+}
+
+static inline void tty_schedule_flip(struct tty_struct *tty)
+{
+	schedule_delayed_work(&tty->flip.work, 1);
+}
+
+#endif
@@ -0,0 +1,20 @@
+/*
+ * The host's <linux/types.h> supplies the __u8 style types the uapi
+ * headers want; the kernel's own short names are added here.
+ */
+#ifndef _VTBENCH_LINUX_TYPES_H
+#define _VTBENCH_LINUX_TYPES_H
+
+#include_next <linux/types.h>
+#include <sys/types.h>
+
+typedef __u8	u8;
+typedef __u16	u16;
+typedef __u32	u32;
+typedef __u64	u64;
+typedef __s8	s8;
+typedef __s16	s16;
+typedef __s32	s32;
+typedef __s64	s64;
+
+#endif
@@ -0,0 +1,24 @@
+/*
+ * The screen buffer is plain memory, as it is on everything but VGA
+ * text mode with VT_BUF_VRAM_ONLY.
+ */
+#ifndef _VTBENCH_VT_BUFFER_H
+#define _VTBENCH_VT_BUFFER_H
+
+#include <kstub.h>
+
+#define scr_writew(val, addr)	(*(addr) = (val))
+#define scr_readw(addr)		(*(addr))
+#define scr_memcpyw(d, s, c)	memcpy(d, s, c)
+#define scr_memmovew(d, s, c)	memmove(d, s, c)
+#define VT_BUF_HAVE_MEMCPYW
+#define VT_BUF_HAVE_MEMMOVEW
+
+static inline void scr_memsetw(u16 *s, u16 c, unsigned int count)
+{
+	count /= 2;
+	while (count--)
+		scr_writew(c, s++);
+}
+
+#endif
@@ -0,0 +1,257 @@
+/*
+ * vtbench.c - replay terminal output through the console code of the
+ * kernel tree and report how fast it goes and what reaches the display.
+ *
+ * vt.c, decvte.c and consolemap.c are built as they are, on top of the
+ * stubs in kstub.c and the recording backend in recordcon.c.  For each
+ * corpus the output is written to the tty in write(2) sized chunks and
+ * the best of a few runs is reported, with the backend calls per byte
+ * of output.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <getopt.h>
+
+#include <linux/tty.h>
+#include <linux/vt_kern.h>
+
+#include "recordcon.h"
+#include "corpus.h"
+
+#define MAX_HEADS	8
+#define VCS_PER_HEAD	4
+
+struct head {
+	struct rec_display *disp;
+	struct tty_struct *tty;
+	pthread_t thread;
+};
+
+static struct head heads[MAX_HEADS];
+static int nr_heads = 1;
+static int chunk = 4096;
+static int utf8_mode = -1;	/* -1: as the corpus wants */
+static int slow_path;
+static struct corpus_buf corpus;
+
+static void usage(void)
+{
+	const struct corpus *c;
+
+	fprintf(stderr,
+		"usage: vtbench [options] [corpus|file]...\n"
+		"  -g COLSxROWS  display geometry (80x25)\n"
+		"  -s BYTES      size of the built-in corpora (4M)\n"
+		"  -r RUNS       runs per corpus, best one reported (5)\n"
+		"  -w BYTES      bytes per write (4096)\n"
+		"  -u / -8       force UTF-8 / 8-bit mode\n"
+		"  -S            byte by byte decoder only (UTF-8 mode, no plain text path)\n"
+		"  -p            display without con_bmove/con_scroll_region\n"
+		"  -H HEADS      write to that many displays at once, one thread each\n"
+		"  -t FILE       log the backend calls of the first display\n"
+		"built-in corpora:\n");
+	for (c = corpora; c->name; c++)
+		fprintf(stderr, "  %-8s %s\n", c->name, c->desc);
+	exit(2);
+}
+
+static size_t parse_size(const char *s)
+{
+	char *end;
+	size_t n = strtoul(s, &end, 0);
+
+	if (*end == 'k' || *end == 'K')
+		n <<= 10;
+	else if (*end == 'm' || *end == 'M')
+		n <<= 20;
+	return n;
+}
+
+static void *head_write(void *private)
+{
+	struct head *h = private;
+	size_t done, n;
+
+	for (done = 0; done < corpus.len; done += n) {
+		n = corpus.len - done < (size_t) chunk ? corpus.len - done : (size_t) chunk;
+		rec_write(h->tty, corpus.data + done, n);
+	}
+	return NULL;
+}
+
+/* Back to a cleared screen in the wanted mode, with fresh counters */
+static void head_reset(struct head *h, int utf8)
+{
+	struct vc_data *vc = h->tty->driver_data;
+
+	rec_write(h->tty, (const unsigned char *) "\033c", 2);
+	/* Not through ESC % G: older trees do not know it */
+	vc->vc_utf = utf8;
+	vc->vc_utf_count = 0;
+	vc->vc_toggle_meta = slow_path;
+	rec_reset_stats(h->disp);
+}
+
+static int run(const char *name, int utf8, int runs)
+{
+	unsigned long long best = ~0ULL, wait = 0, t;
+	struct rec_stats total;
+	int i, r, bad = 0;
+	double bytes, mb;
+
+	for (r = 0; r < runs; r++) {
+		for (i = 0; i < nr_heads; i++)
+			head_reset(&heads[i], utf8);
+		kstub_console_wait_ns = 0;
+		t = sched_clock();
+		if (nr_heads == 1) {
+			head_write(&heads[0]);
+		} else {
+			for (i = 0; i < nr_heads; i++)
+				pthread_create(&heads[i].thread, NULL, head_write, &heads[i]);
+			for (i = 0; i < nr_heads; i++)
+				pthread_join(heads[i].thread, NULL);
+		}
+		t = sched_clock() - t;
+		if (t < best) {
+			best = t;
+			wait = kstub_console_wait_ns;
+		}
+	}
+
+	memset(&total, 0, sizeof(total));
+	for (i = 0; i < nr_heads; i++) {
+		const struct rec_stats *s = &heads[i].disp->stats;
+
+		total.putcs += s->putcs;
+		total.putcs_cells += s->putcs_cells;
+		total.putc += s->putc;
+		total.bmove += s->bmove;
+		total.bmove_cells += s->bmove_cells;
+		total.scroll += s->scroll;
+		total.clear += s->clear;
+		bad += rec_verify(heads[i].disp);
+	}
+
+	bytes = (double) corpus.len * nr_heads;
+	mb = bytes / (1 << 20);
+	printf("%-10s %9.0f %8.2f %8.4f %8.4f %8.3f %8lu %8lu",
+	       name, bytes, mb / (best / 1e9), rec_calls(&total) / bytes,
+	       total.putcs / bytes, (total.putcs_cells + total.putc) / bytes,
+	       total.bmove, total.scroll);
+	if (nr_heads > 1)
+		printf(" %8.3f", wait / 1e6 / mb);
+	printf("%s\n", bad ? "  DISPLAY MISMATCH" : "");
+	return bad;
+}
+
+int main(int argc, char **argv)
+{
+	const struct consw *sw = &rec_con;
+	int cols = 80, rows = 25, runs = 5, i, opt, bad = 0;
+	size_t size = 4 << 20;
+	FILE *trace = NULL;
+
+	while ((opt = getopt(argc, argv, "g:s:r:w:u8SpH:t:h")) != -1) {
+		switch (opt) {
+		case 'g':
+			if (sscanf(optarg, "%dx%d", &cols, &rows) != 2 ||
+			    cols < 20 || rows < 5)
+				usage();
+			break;
+		case 's':
+			size = parse_size(optarg);
+			break;
+		case 'r':
+			runs = atoi(optarg);
+			break;
+		case 'w':
+			chunk = atoi(optarg);
+			break;
+		case 'u':
+			utf8_mode = 1;
+			break;
+		case '8':
+			utf8_mode = 0;
+			break;
+		case 'S':
+			/* vc_toggle_meta only keeps the decoder out of the plain text path in UTF-8 mode */
+			slow_path = 1;
+			utf8_mode = 1;
+			break;
+		case 'p':
+			sw = &rec_con_plain;
+			break;
+		case 'H':
+			nr_heads = atoi(optarg);
+			break;
+		case 't':
+			trace = fopen(optarg, "w");
+			if (!trace) {
+				perror(optarg);
+				return 1;
+			}
+			break;
+		default:
+			usage();
+		}
+	}
+	if (runs < 1 || chunk < 1 || nr_heads < 1 || nr_heads > MAX_HEADS)
+		usage();
+
+	for (i = 0; i < nr_heads; i++) {
+		heads[i].disp = rec_add_display(sw, cols, rows, VCS_PER_HEAD);
+		if (!heads[i].disp) {
+			fprintf(stderr, "vtbench: cannot set up display %d\n", i);
+			return 1;
+		}
+	}
+	if (rec_start()) {
+		fprintf(stderr, "vtbench: vty_init failed\n");
+		return 1;
+	}
+	for (i = 0; i < nr_heads; i++) {
+		heads[i].tty = rec_open(heads[i].disp->vt.first_vc);
+		if (!heads[i].tty) {
+			fprintf(stderr, "vtbench: cannot open the tty of display %d\n", i);
+			return 1;
+		}
+	}
+	heads[0].disp->trace = trace;
+
+	printf("%-10s %9s %8s %8s %8s %8s %8s %8s%s\n", "corpus", "bytes",
+	       "MB/s", "calls/B", "putcs/B", "cells/B", "bmove", "scroll",
+	       nr_heads > 1 ? " wait ms/MB" : "");
+	if (optind == argc) {
+		const struct corpus *c;
+
+		for (c = corpora; c->name; c++) {
+			corpus_make(&corpus, c, size, cols, rows);
+			bad += run(c->name, utf8_mode < 0 ? c->utf8 : utf8_mode, runs);
+		}
+	}
+	for (i = optind; i < argc; i++) {
+		const struct corpus *c = corpus_find(argv[i]);
+		const char *name = strrchr(argv[i], '/');
+
+		if (c) {
+			corpus_make(&corpus, c, size, cols, rows);
+			bad += run(c->name, utf8_mode < 0 ? c->utf8 : utf8_mode, runs);
+			continue;
+		}
+		if (corpus_load(&corpus, argv[i])) {
+			perror(argv[i]);
+			return 1;
+		}
+		bad += run(name ? name + 1 : argv[i], utf8_mode > 0, runs);
+	}
+	if (trace)
+		fclose(trace);
+	if (kstub_warnings)
+		fprintf(stderr, "vtbench: %lu warnings\n", kstub_warnings);
+	return bad || kstub_warnings;
+}
@@ -0,0 +1,402 @@
+/*
+ * vtcheck.c - check the console code of the kernel tree against plain
+ * reference implementations, on the same stubs and recording backend
+ * as vtbench.
+ *
+ * Each test feeds seeded random input and reports the first few
+ * differences with the seed of their round; "vtcheck -s SEED -n 1"
+ * repeats just that round.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <getopt.h>
+#include <stdarg.h>
+
+#include <linux/tty.h>
+#include <linux/vt_kern.h>
+#include <linux/vt_buffer.h>
+
+#include "recordcon.h"
+
+#define MAX_RUNS	4096
+#define MAX_STREAM	1024
+
+static unsigned int seed = 1;
+static int rounds = 2000;
+static int failed;
+
+static unsigned long rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) & 0x7fff;
+}
+
+static void fail(const char *test, const char *fmt, ...)
+	__attribute__ ((format (printf, 2, 3)));
+
+static void fail(const char *test, const char *fmt, ...)
+{
+	va_list ap;
+
+	if (failed++ >= 8)
+		return;
+	fprintf(stderr, "%s: ", test);
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+}
+
+/*
+ * do_update_region() and the attribute runs it hands to con_putcs.
+ * The putcs calls are logged here on their way to the recording
+ * backend, and compared with the runs a cell by cell scan finds: one
+ * per stretch of equal attribute bytes, never across a line end.
+ */
+
+struct run {
+	int y, x, count;
+};
+
+static struct run runs[MAX_RUNS];
+static int nr_runs;
+static struct consw run_con;
+
+static void run_putcs(struct vc_data *vc, const unsigned short *s, int count,
+		      int y, int x)
+{
+	if (nr_runs < MAX_RUNS) {
+		runs[nr_runs].y = y;
+		runs[nr_runs].x = x;
+		runs[nr_runs].count = count;
+	}
+	nr_runs++;
+	rec_con.con_putcs(vc, s, count, y, x);
+}
+
+static int scalar_runs(const u16 *screen, int cols, int start, int count,
+		       struct run *ref)
+{
+	int i, n = 0;
+
+	for (i = start; i < start + count; i++) {
+		if (i == start || i % cols == 0 ||
+		    (screen[i] & 0xff00) != (screen[i - 1] & 0xff00)) {
+			ref[n].y = i / cols;
+			ref[n].x = i % cols;
+			ref[n].count = 0;
+			n++;
+		}
+		ref[n - 1].count++;
+	}
+	return n;
+}
+
+static void check_attr_runs(struct rec_display *disp)
+{
+	static struct run ref[MAX_RUNS];
+	struct vc_data *vc = disp->vt.fg_console;
+	u16 *screen = (u16 *) vc->vc_origin;
+	int cells = vc->vc_cols * vc->vc_rows;
+	int r, i, n;
+
+	for (r = 0; r < rounds; r++) {
+		/*
+		 * Long runs, single cells and everything in between, so
+		 * the word scan stops at every offset within a long.
+		 */
+		unsigned int round_seed = seed;
+		int mix = 1 + rnd() % 16;
+		u16 attr = rnd() << 8;
+		int start, count;
+
+		for (i = 0; i < cells; i++) {
+			if (rnd() % mix == 0)
+				attr = (rnd() % 4) << 8 | (rnd() & 1) << 15;
+			scr_writew(attr | ('a' + rnd() % 26), screen + i);
+		}
+		start = rnd() % cells;
+		switch (rnd() % 3) {
+		case 0:		/* shorter than a long */
+			count = 1 + rnd() % (2 * sizeof(long) / sizeof(u16));
+			break;
+		case 1:		/* to the end of the line, or just short of it */
+			count = vc->vc_cols - start % vc->vc_cols - rnd() % 3;
+			break;
+		default:
+			count = 1 + rnd() % (cells - start);
+		}
+		if (count < 1)
+			count = 1;
+		if (count > cells - start)
+			count = cells - start;
+
+		nr_runs = 0;
+		do_update_region(vc, (unsigned long) (screen + start), count);
+		n = scalar_runs(screen, vc->vc_cols, start, count, ref);
+		if (nr_runs != n) {
+			fail("attr_run", "seed %u: %d cells from %d: %d runs, expected %d",
+			     round_seed, count, start, nr_runs, n);
+			continue;
+		}
+		for (i = 0; i < n; i++) {
+			if (runs[i].y == ref[i].y && runs[i].x == ref[i].x &&
+			    runs[i].count == ref[i].count)
+				continue;
+			fail("attr_run", "seed %u: %d cells from %d: run %d is %d,%d+%d, expected %d,%d+%d",
+			     round_seed, count, start, i, runs[i].y, runs[i].x,
+			     runs[i].count, ref[i].y, ref[i].x, ref[i].count);
+			break;
+		}
+	}
+	/* What was drawn has to be what the buffer holds */
+	do_update_region(vc, vc->vc_origin, cells);
+	if (rec_verify(disp))
+		fail("attr_run", "display differs from the screen buffer");
+}
+
+/*
+ * The UTF-8 decoding of the plain text path against the byte by byte
+ * decoder, which a console with vc_toggle_meta set is left to.  Both
+ * get the same stream of characters, valid and malformed, cut into
+ * writes at random points so that sequences are carried from one write
+ * to the next; after every write their screens, cursors and decoder
+ * states have to agree.
+ *
+ * CR, LF, BS and TAB aside, nothing here decodes to a C0 control or
+ * to CSI: a stray escape sequence could set vc_toggle_meta and end the
+ * comparison.
+ */
+
+static int put_utf8(unsigned char *p, unsigned int c, int len)
+{
+	int i;
+
+	for (i = len - 1; i > 0; i--) {
+		p[i] = 0x80 | (c & 0x3f);
+		c >>= 6;
+	}
+	p[0] = (0xff00 >> len) | c;
+	return len;
+}
+
+/*
+ * Most of Unicode has no glyph in the default font, and stops the plain
+ * text path just like a control; these do not.  Returns the length.
+ */
+static int font_char(unsigned char *p)
+{
+	switch (rnd() % 3) {
+	case 0:		/* Latin-1 */
+		return put_utf8(p, 0xa0 + rnd() % 0x60, 2);
+	case 1:		/* box drawing and blocks */
+		return put_utf8(p, 0x2500 + rnd() % 0xa0, 3);
+	default:	/* straight to the font */
+		return put_utf8(p, 0xf000 + rnd() % 0x100, 3);
+	}
+}
+
+/* A character that fits len bytes: U+0020 and up, but for CSI */
+static unsigned int utf8_char(int len)
+{
+	static const unsigned int top[] = { 0, 0x7f, 0x7ff, 0xffff, 0x1fffff };
+	unsigned int c;
+
+	do
+		c = 0x20 + (rnd() << 15 | rnd()) % (top[len] - 0x1f);
+	while (c == 0x9b);
+	return c;
+}
+
+static int utf8_stream(unsigned char *p)
+{
+	int len = 0, i, n;
+
+	while (len < MAX_STREAM - 8) {
+		switch (rnd() % 12) {
+		case 0:		/* plain text */
+		case 1:
+			for (i = 1 + rnd() % 16; i && len < MAX_STREAM - 8; i--)
+				p[len++] = 0x20 + rnd() % 0x5f;
+			break;
+		case 2:		/* characters the font has */
+		case 3:
+			for (i = 1 + rnd() % 8; i && len < MAX_STREAM - 8; i--)
+				len += font_char(p + len);
+			break;
+		case 4:		/* anything, up to U+1FFFFF */
+			n = 2 + rnd() % 3;
+			len += put_utf8(p + len, utf8_char(n), n);
+			break;
+		case 5:		/* overlong */
+			n = 2 + rnd() % 3;
+			len += put_utf8(p + len, utf8_char(n - 1 - rnd() % (n - 1)), n);
+			break;
+		case 6:		/* surrogates, U+FFFE/U+FFFF, past U+10FFFF */
+			n = rnd() % 3;
+			len += put_utf8(p + len, n == 0 ? 0xd800 + rnd() % 0x800 :
+					n == 1 ? 0xfffe + rnd() % 2 : 0x110000 + rnd(),
+					n == 2 ? 4 : 3);
+			break;
+		case 7:		/* cut short */
+			if (rnd() % 2) {
+				n = font_char(p + len);
+			} else {
+				n = 2 + rnd() % 3;
+				put_utf8(p + len, utf8_char(n), n);
+			}
+			len += 1 + rnd() % (n - 1);
+			break;
+		case 8:		/* stray continuation bytes */
+			for (i = 1 + rnd() % 3; i; i--)
+				p[len++] = 0x80 + rnd() % 0x40;
+			break;
+		case 9:		/* five and six byte forms, 0xfe and 0xff */
+			n = 0xf8 + rnd() % 8;
+			p[len++] = n;
+			if (n >= 0xfe)
+				break;
+			/* well above the controls if it gets through */
+			p[len++] = 0x81 + rnd() % 0x3f;
+			for (i = (n < 0xfc ? 3 : 4) - rnd() % 2; i; i--)
+				p[len++] = 0x80 + rnd() % 0x40;
+			break;
+		case 10:	/* to the end of the line and past it */
+			for (i = rnd() % 100; i && len < MAX_STREAM - 8; i--)
+				p[len++] = 'A' + rnd() % 26;
+			break;
+		default:
+			p[len++] = "\r\n\b\t"[rnd() % 4];
+		}
+	}
+	return len;
+}
+
+static void utf8_reset(struct tty_struct *tty, int toggle_meta)
+{
+	struct vc_data *vc = tty->driver_data;
+
+	rec_write(tty, (const unsigned char *) "\033c", 2);
+	vc->vc_utf = 1;
+	vc->vc_utf_count = 0;
+	vc->vc_toggle_meta = toggle_meta;
+}
+
+static int utf8_differs(struct vc_data *vc, struct vc_data *ref)
+{
+	const u16 *a = (const u16 *) vc->vc_origin;
+	const u16 *b = (const u16 *) ref->vc_origin;
+	int i;
+
+	for (i = 0; i < vc->vc_cols * vc->vc_rows; i++)
+		if (scr_readw(a + i) != scr_readw(b + i))
+			return i + 1;
+	return vc->vc_x != ref->vc_x || vc->vc_y != ref->vc_y ||
+	       vc->vc_need_wrap != ref->vc_need_wrap ||
+	       vc->vc_utf_count != ref->vc_utf_count ||
+	       (vc->vc_utf_count && vc->vc_utf_char != ref->vc_utf_char);
+}
+
+static void check_utf8(struct rec_display *disp, struct tty_struct *tty,
+		       struct tty_struct *ref_tty)
+{
+	static unsigned char stream[MAX_STREAM], chunk[MAX_STREAM + 4];
+	struct vc_data *vc = tty->driver_data, *ref = ref_tty->driver_data;
+	int r, len, done, n, diff;
+
+	for (r = 0; r < rounds; r++) {
+		unsigned int round_seed = seed;
+
+		utf8_reset(tty, 0);
+		utf8_reset(ref_tty, 1);
+		len = utf8_stream(stream);
+		for (done = 0; done < len; done += n) {
+			n = rnd() % 4 ? 1 + rnd() % 8 : 1 + rnd() % (len - done);
+			if (n > len - done)
+				n = len - done;
+			/*
+			 * Past the end, bytes that must not be read; they
+			 * would complete a cut short E2 to box drawing.
+			 */
+			memcpy(chunk, stream + done, n);
+			memset(chunk + n, 0x94, 4);
+			rec_write(tty, chunk, n);
+			rec_write(ref_tty, chunk, n);
+			if (!(diff = utf8_differs(vc, ref)))
+				continue;
+			if (diff > 1)
+				fail("utf8", "seed %u: after byte %d: cell %d,%d is %04x, expected %04x",
+				     round_seed, done + n, (diff - 1) / vc->vc_cols,
+				     (diff - 1) % vc->vc_cols,
+				     scr_readw((u16 *) vc->vc_origin + diff - 1),
+				     scr_readw((u16 *) ref->vc_origin + diff - 1));
+			else
+				fail("utf8", "seed %u: after byte %d: cursor %d,%d%s utf %d/%x, expected %d,%d%s utf %d/%x",
+				     round_seed, done + n, vc->vc_y, vc->vc_x,
+				     vc->vc_need_wrap ? "+" : "", vc->vc_utf_count,
+				     vc->vc_utf_char, ref->vc_y, ref->vc_x,
+				     ref->vc_need_wrap ? "+" : "", ref->vc_utf_count,
+				     ref->vc_utf_char);
+			break;
+		}
+		if (rec_verify(disp))
+			fail("utf8", "seed %u: display differs from the screen buffer",
+			     round_seed);
+	}
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: vtcheck [options]\n"
+		"  -s SEED       first seed (1)\n"
+		"  -n ROUNDS     rounds per test (2000)\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	struct rec_display *disp;
+	struct tty_struct *tty, *ref_tty;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:n:h")) != -1) {
+		switch (opt) {
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			rounds = atoi(optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+
+	run_con = rec_con;
+	run_con.con_putcs = run_putcs;
+	disp = rec_add_display(&run_con, 80, 25, 2);
+	if (!disp || rec_start()) {
+		fprintf(stderr, "vtcheck: cannot set up the display\n");
+		return 1;
+	}
+	tty = rec_open(disp->vt.first_vc);
+	ref_tty = rec_open(disp->vt.first_vc + 1);
+	if (!tty || !ref_tty) {
+		fprintf(stderr, "vtcheck: cannot open the tty\n");
+		return 1;
+	}
+
+	check_attr_runs(disp);
+	check_utf8(disp, tty, ref_tty);
+
+	if (kstub_warnings)
+		fprintf(stderr, "vtcheck: %lu warnings\n", kstub_warnings);
+	if (failed)
+		fprintf(stderr, "vtcheck: %d failures\n", failed);
+	return failed || kstub_warnings;
+}
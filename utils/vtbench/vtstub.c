@@ -0,0 +1,83 @@
+/*
+ * vtstub.c - stand-ins for the parts of the console drivers that are
+ * not linked into the harness: selection, /dev/vcs, the VT ioctls and
+ * sysfs.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <linux/tty.h>
+#include <linux/vt_kern.h>
+#include <linux/selection.h>
+
+/* Selection: nothing is ever selected */
+struct vc_data *sel_cons;
+
+void clear_selection(void)
+{
+}
+
+int set_selection(const struct tiocl_selection __user *sel, struct tty_struct *tty)
+{
+	return -EINVAL;
+}
+
+int paste_selection(struct tty_struct *tty)
+{
+	return 0;
+}
+
+void paste_work(void *private)
+{
+}
+
+void paste_cancel(struct vc_data *vc)
+{
+}
+
+int sel_loadlut(char __user *p)
+{
+	return -EINVAL;
+}
+
+/* /dev/vcs */
+void vcs_scr_updated(struct vc_data *vc)
+{
+}
+
+int vcs_init(void)
+{
+	return 0;
+}
+
+void vcs_make_devfs(struct tty_struct *tty)
+{
+}
+
+void vcs_remove_devfs(struct tty_struct *tty)
+{
+}
+
+/* VT ioctls and switching */
+int vt_ioctl(struct tty_struct *tty, struct file *file,
+	     unsigned int cmd, unsigned long arg)
+{
+	return -ENOIOCTLCMD;
+}
+
+void change_console(struct vc_data *new_vc, struct vc_data *old_vc)
+{
+}
+
+/* sysfs */
+int vt_create_sysfs_dev_files(struct vt_struct *vt)
+{
+	return 0;
+}
+
+void vt_sysfs_init(void)
+{
+}